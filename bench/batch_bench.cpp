@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "batch_game.h"
+
+// Batch benchmark: steps/sec of BatchGame for an increasing number of threads.
+// usage: breakout_batch_bench [games] [steps]
+
+const unsigned int SCREEN_WIDTH = 2400;
+const unsigned int SCREEN_HEIGHT = 1200;
+const float TIME_STEP = 1.0f / 60.0f;
+
+int main(int argc, char* argv[])
+{
+	unsigned int games = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 4096;
+	unsigned int steps = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 1000;
+	unsigned int hardware = std::thread::hardware_concurrency();
+	if (hardware == 0)
+		hardware = 1;
+
+	// powers of two up to the number of hardware threads
+	std::vector<unsigned int> threadCounts;
+	for (unsigned int threads = 1; threads < hardware; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(hardware);
+
+	std::cout << "games: " << games << ", steps: " << steps << std::endl;
+	std::cout << "threads\tsteps/sec\tspeedup" << std::endl;
+	double baseline = 0.0;
+	for (unsigned int threads : threadCounts)
+	{
+		BatchGame batch(games, SCREEN_WIDTH, SCREEN_HEIGHT, threads);
+		std::vector<Action> actions(games, ACTION_LAUNCH);
+		std::vector<Observation> observations(games);
+
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int step = 0; step < steps; ++step)
+		{
+			batch.Step(actions.data(), observations.data(), TIME_STEP);
+			// follow the ball with the paddle
+			for (unsigned int i = 0; i < games; ++i)
+			{
+				const Observation& o = observations[i];
+				if (o.Stuck)
+					actions[i] = ACTION_LAUNCH;
+				else
+				{
+					float ballCenter = o.BallPosition.x + BALL_RADIUS;
+					float playerCenter = o.PlayerPosition + o.PlayerWidth / 2.0f;
+					actions[i] = ballCenter < playerCenter ? ACTION_LEFT : ACTION_RIGHT;
+				}
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		double rate = games * static_cast<double>(steps) / seconds;
+		if (threads == 1)
+			baseline = rate;
+		std::cout << threads << "\t" << static_cast<unsigned long long>(rate) << "\t" << rate / baseline << std::endl;
+	}
+	return 0;
+}
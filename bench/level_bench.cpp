@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "game_level.h"
+#include "game_random.h"
+
+// Level loading benchmark: parse time of a generated square level with the
+// stream based loader the game used to have, the mapped text parser and the
+// binary format, and the time to reset the loaded level.
+// usage: breakout_level_bench [size]
+
+const unsigned int SCREEN_WIDTH = 2400;
+const unsigned int SCREEN_HEIGHT = 1200;
+
+// stream based loader: a string stream per line into a vector of rows
+unsigned int LoadStreams(const char* file)
+{
+	unsigned int tileCode;
+	std::string line;
+	std::ifstream fstream(file);
+	std::vector<std::vector<unsigned int>> tileData;
+	while (std::getline(fstream, line))
+	{
+		std::istringstream sstream(line);
+		std::vector<unsigned int> row;
+		while (sstream >> tileCode)
+			row.push_back(tileCode);
+		tileData.push_back(row);
+	}
+	// the rows were handed to init by value
+	std::vector<std::vector<unsigned int>> copy = tileData;
+	return static_cast<unsigned int>(copy.size());
+}
+
+// milliseconds taken by load (best of a few runs)
+template <typename F>
+double Measure(F load)
+{
+	double best = 1e30;
+	for (int run = 0; run < 3; ++run)
+	{
+		auto start = std::chrono::steady_clock::now();
+		load();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int size = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 4096;
+	const char* textFile = "level_bench.lvl";
+	const char* binaryFile = "level_bench.lvlb";
+
+	// random level in the text format
+	{
+		RandomStream random;
+		random.Seed(size);
+		std::ofstream out(textFile);
+		std::string line;
+		for (unsigned int y = 0; y < size; ++y)
+		{
+			line.clear();
+			for (unsigned int x = 0; x < size; ++x)
+			{
+				line += static_cast<char>('0' + random.Below(6));
+				line += x + 1 < size ? ' ' : '\n';
+			}
+			out << line;
+		}
+	}
+	GameLevel level;
+	level.Load(textFile, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
+	level.Save(binaryFile);
+
+	std::cout << "level: " << size << "x" << size << std::endl;
+	std::cout << "loader\tms" << std::endl;
+	std::cout << "streams\t" << Measure([&]() { LoadStreams(textFile); }) << std::endl;
+	std::cout << "text\t" << Measure([&]() { level.Load(textFile, SCREEN_WIDTH, SCREEN_HEIGHT / 2); }) << std::endl;
+	std::cout << "binary\t" << Measure([&]() { level.Load(binaryFile, SCREEN_WIDTH, SCREEN_HEIGHT / 2); }) << std::endl;
+	std::cout << "reset\t" << Measure([&]() { level.Reset(); }) << std::endl;
+
+	std::remove(textFile);
+	std::remove(binaryFile);
+	return 0;
+}
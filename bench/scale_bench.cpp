@@ -0,0 +1,134 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "level_generator.h"
+
+// Scaling benchmark: generated levels of 10^2 to 10^6 tiles (or up to the given
+// power of ten), with the time to load them (text, binary and chunked file),
+// to draw them, to run Game::DoCollisions on them and to save and restore a
+// snapshot of the game playing them. Drawing is measured without GL: the
+// bricks the renderer would submit (the ones in view, and for comparison all
+// of them) are gathered into a sprite list.
+// usage: breakout_scale_bench [max power of ten]
+
+const unsigned int SCREEN_WIDTH = 2400;
+const unsigned int SCREEN_HEIGHT = 1200;
+// DoCollisions calls per level (the ball is placed at random over the bricks)
+const unsigned int COLLISION_STEPS = 100000;
+
+// what DrawSprite is given for a brick
+struct SpriteInstance
+{
+	glm::vec2	Position, Size;
+	glm::vec3	Colour;
+	bool		Solid;
+};
+
+// milliseconds taken by run (best of a few runs)
+template <typename F>
+double Measure(F run)
+{
+	double best = 1e30;
+	for (int attempt = 0; attempt < 3; ++attempt)
+	{
+		auto start = std::chrono::steady_clock::now();
+		run();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+// adds the brick in cell to the sprite list the way GameRenderer draws it
+void Submit(std::vector<SpriteInstance>& sprites, const GameLevel& level, unsigned int cell)
+{
+	sprites.push_back({ level.BrickPosition(cell), level.BrickSize, level.BrickColour(cell), level.IsSolid(cell) });
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int maxPower = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 6;
+	const char* textFile = "scale_bench.lvl";
+	const char* binaryFile = "scale_bench.lvlb";
+	const char* chunkedFile = "scale_bench.lvlc";
+
+	// the game is set up with the shipped levels, the generated level replaces the current one
+	Game game(SCREEN_WIDTH, SCREEN_HEIGHT);
+	game.Init();
+	game.State = GAME_ACTIVE;
+	game.Ball.Stuck = false;
+
+	std::cout << "tiles\tgrid\ttext ms\tbinary ms\tchunked ms\tdraw view us\tdraw all us\tsprites\tcollisions us\tsave us\trestore us" << std::endl;
+	for (unsigned int power = 2; power <= maxPower; ++power)
+	{
+		// square grid of about 10^power tiles
+		unsigned int side = static_cast<unsigned int>(std::lround(std::sqrt(std::pow(10.0, power))));
+		LevelRecipe recipe = DEFAULT_RECIPE;
+		recipe.Columns = recipe.Rows = side;
+		recipe.Seed = power;
+		GameLevel level;
+		level.Create(GenerateTiles(recipe), side, side, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
+		level.SaveText(textFile);
+		level.Save(binaryFile);
+		level.SaveChunked(chunkedFile);
+
+		GameLevel loaded;
+		double text = Measure([&]() { loaded.Load(textFile, SCREEN_WIDTH, SCREEN_HEIGHT / 2); });
+		double binary = Measure([&]() { loaded.Load(binaryFile, SCREEN_WIDTH, SCREEN_HEIGHT / 2); });
+		double chunked = Measure([&]() { loaded.Load(chunkedFile, SCREEN_WIDTH, SCREEN_HEIGHT / 2); });
+
+		// draw with the camera in the middle of the level
+		std::vector<SpriteInstance> sprites;
+		sprites.reserve(level.LiveBricks);
+		glm::vec2 view = glm::max(level.Size() / 2.0f - glm::vec2(SCREEN_WIDTH, SCREEN_HEIGHT) / 2.0f, glm::vec2(0.0f));
+		double drawView = Measure([&]()
+		{
+			sprites.clear();
+			level.ForEachLiveIn(view, view + glm::vec2(SCREEN_WIDTH, SCREEN_HEIGHT), [&](unsigned int cell) { Submit(sprites, level, cell); });
+		});
+		size_t visible = sprites.size();
+		double drawAll = Measure([&]()
+		{
+			sprites.clear();
+			level.ForEachLive([&](unsigned int cell) { Submit(sprites, level, cell); });
+		});
+
+		// collisions with the ball dropped at random places over the level
+		game.Levels[game.Level] = level;
+		game.ResetPlayer();
+		game.Ball.Stuck = false;
+		RandomStream random(power);
+		glm::vec2 size = level.Size();
+		std::vector<glm::vec2> positions(COLLISION_STEPS);
+		for (glm::vec2& position : positions)
+			position = glm::vec2(random.Float(), random.Float()) * size;
+		auto start = std::chrono::steady_clock::now();
+		for (const glm::vec2& position : positions)
+		{
+			game.Ball.Position = position;
+			game.Ball.Velocity = BALL_VELOCITY;
+			game.DoCollisions();
+		}
+		double collisions = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / COLLISION_STEPS;
+		game.DispatchEvents();
+
+		// snapshot of the game (the bitmap of the level is most of it)
+		std::vector<uint8_t> snapshot;
+		double save = Measure([&]() { game.Save(snapshot); });
+		double restore = Measure([&]() { game.Restore(snapshot); });
+
+		std::cout << side * side << "\t" << side << "x" << side << "\t" << text << "\t" << binary << "\t" << chunked
+			<< "\t" << drawView * 1000.0 << "\t" << drawAll * 1000.0 << "\t" << visible << "/" << sprites.size()
+			<< "\t" << collisions << "\t" << save * 1000.0 << "\t" << restore * 1000.0 << std::endl;
+	}
+
+	std::remove(textFile);
+	std::remove(binaryFile);
+	std::remove(chunkedFile);
+	return 0;
+}
\ No newline at end of file
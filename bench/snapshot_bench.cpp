@@ -0,0 +1,137 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "autopilot.h"
+#include "game.h"
+#include "level_generator.h"
+#include "replay.h"
+
+// Snapshot benchmark: saves the game while the autopilot plays a shipped level,
+// the endless level and a generated chunked level, runs on, restores the snapshot
+// and runs the same frames again. The state right after restoring has to be the
+// one saved, and the re-run has to end in the state of the first run (compared
+// field by field, see StateChecksum). A corrupted snapshot naming another level
+// has to be rejected without changing the game. Prints the snapshot size (and the
+// chunks with destroyed bricks it holds), the time to save and restore it and the checks; the exit code is 1 if one failed.
+// usage: breakout_snapshot_bench [frames]
+
+const unsigned int SCREEN_WIDTH = 2400;
+const unsigned int SCREEN_HEIGHT = 1200;
+const float TIME_STEP = 1.0f / 60.0f;
+// frames played before the snapshot is taken, so it holds bricks, power-ups and timers
+const unsigned int WARMUP_FRAMES = 600;
+
+// microseconds taken by run (best of a few runs)
+template <typename F>
+double Measure(F run)
+{
+	double best = 1e30;
+	for (int attempt = 0; attempt < 5; ++attempt)
+	{
+		auto start = std::chrono::steady_clock::now();
+		run();
+		best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+// plays frames with the autopilot, starting over when the game is lost or won
+void Run(Game& game, Autopilot& autopilot, unsigned int frames)
+{
+	for (unsigned int frame = 0; frame < frames; ++frame)
+	{
+		if (game.State != GAME_ACTIVE)
+		{
+			game.Effects.Chaos = false;
+			game.State = GAME_ACTIVE;
+		}
+		autopilot.Control(game);
+		game.ProcessInput(TIME_STEP);
+		game.Update(TIME_STEP);
+	}
+}
+
+// saves, runs, restores and re-runs the game on its current level and prints a row
+bool RoundTrip(const char* name, Game& game, unsigned int frames)
+{
+	std::vector<uint8_t> scratch, start, end;
+	game.State = GAME_ACTIVE;
+	Autopilot autopilot;
+	Run(game, autopilot, WARMUP_FRAMES);
+
+	game.Save(start);
+	uint64_t started = StateChecksum(game, scratch);
+	Autopilot saved = autopilot;
+	Run(game, autopilot, frames);
+	uint64_t ended = StateChecksum(game, scratch);
+
+	bool restored = game.Restore(start) && StateChecksum(game, scratch) == started;
+	autopilot = saved;
+	Run(game, autopilot, frames);
+	bool rerun = StateChecksum(game, scratch) == ended;
+
+	// a snapshot naming another level whose bricks do not fit it leaves the game as it is
+	std::vector<uint8_t> corrupt = start;
+	GameSnapshot header;
+	std::memcpy(&header, corrupt.data(), sizeof(header));
+	header.Level = (game.Level + 1) % static_cast<uint32_t>(game.Levels.size());
+	++header.Bricks.Words;
+	std::memcpy(corrupt.data(), &header, sizeof(header));
+	unsigned int current = game.Level;
+	uint64_t before = StateChecksum(game, scratch);
+	bool rejected = !game.Restore(corrupt) && game.Level == current && StateChecksum(game, scratch) == before;
+
+	double save = Measure([&]() { game.Save(end); });
+	double restore = Measure([&]() { game.Restore(start); });
+	std::cout << name << "\t" << start.size() << "\t" << header.Bricks.Deltas << "\t" << save << "\t" << restore
+		<< "\t" << (restored ? "ok" : "FAILED") << "\t" << (rerun ? "ok" : "FAILED")
+		<< "\t" << (rejected ? "ok" : "FAILED") << std::endl;
+	return restored && rerun && rejected;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int frames = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 3000;
+	const char* chunkedFile = "snapshot_bench.lvlc";
+	bool passed = true;
+
+	std::cout << "level\tbytes\tchunk deltas\tsave us\trestore us\trestored\tre-run\trejected" << std::endl;
+	{
+		Game game(SCREEN_WIDTH, SCREEN_HEIGHT);
+		game.Seed(1);
+		game.Init();
+		game.SelectLevel(0);
+		passed = RoundTrip("standard", game, frames) && passed;
+	}
+	{
+		Game game(SCREEN_WIDTH, SCREEN_HEIGHT);
+		game.Seed(2);
+		game.Init();
+		game.SelectLevel(static_cast<unsigned int>(game.Levels.size()) - 1);
+		passed = RoundTrip("endless", game, frames) && passed;
+	}
+	{
+		// a generated level saved in chunks takes the place of the first level
+		LevelRecipe recipe = DEFAULT_RECIPE;
+		recipe.Columns = recipe.Rows = 400;
+		recipe.Seed = 3;
+		GameLevel level;
+		level.Create(GenerateTiles(recipe), recipe.Columns, recipe.Rows, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
+		level.SaveChunked(chunkedFile);
+		Game game(SCREEN_WIDTH, SCREEN_HEIGHT);
+		game.Seed(3);
+		game.Init();
+		game.SelectLevel(0);
+		game.Levels[0].Load(chunkedFile, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
+		game.SelectLevel(0);
+		passed = RoundTrip("chunked", game, frames) && passed;
+	}
+
+	std::remove(chunkedFile);
+	return passed ? 0 : 1;
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "shader.h"
+#include <vector>
 
 
 // read shader files, generate shaders, compile and link them
@@ -45,6 +46,121 @@ void Shader::Compile(const char* vertexSource, const char* fragmentSource, const
 		glDeleteShader(geometry);
 }
 
+// value of a uniform (element) read back from a program
+struct SavedUniform
+{
+	std::string	Name;
+	GLenum		Type;
+	float		Floats[16];
+	int			Int;
+};
+
+// reads the values of all active uniforms (every element of arrays)
+std::vector<SavedUniform> SaveUniforms(unsigned int program)
+{
+	std::vector<SavedUniform> uniforms;
+	int count = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	for (int i = 0; i < count; ++i)
+	{
+		char name[256];
+		GLsizei length;
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(program, i, sizeof(name), &length, &size, &type, name);
+		// arrays are reported as name[0]
+		std::string base(name, length);
+		if (size > 1 && base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+			base.resize(base.size() - 3);
+		for (GLint element = 0; element < size; ++element)
+		{
+			SavedUniform uniform = {};
+			uniform.Name = size > 1 ? base + "[" + std::to_string(element) + "]" : base;
+			uniform.Type = type;
+			int location = glGetUniformLocation(program, uniform.Name.c_str());
+			if (location < 0)
+				continue;
+			if (type == GL_INT || type == GL_BOOL || type == GL_SAMPLER_2D)
+				glGetUniformiv(program, location, &uniform.Int);
+			else
+				glGetUniformfv(program, location, uniform.Floats);
+			uniforms.push_back(uniform);
+		}
+	}
+	return uniforms;
+}
+
+// writes saved uniform values to the (current) program
+void RestoreUniforms(unsigned int program, const std::vector<SavedUniform>& uniforms)
+{
+	for (const SavedUniform& uniform : uniforms)
+	{
+		int location = glGetUniformLocation(program, uniform.Name.c_str());
+		if (location < 0)
+			continue;
+		switch (uniform.Type)
+		{
+		case GL_INT: case GL_BOOL: case GL_SAMPLER_2D: glUniform1i(location, uniform.Int); break;
+		case GL_FLOAT:		glUniform1fv(location, 1, uniform.Floats); break;
+		case GL_FLOAT_VEC2:	glUniform2fv(location, 1, uniform.Floats); break;
+		case GL_FLOAT_VEC3:	glUniform3fv(location, 1, uniform.Floats); break;
+		case GL_FLOAT_VEC4:	glUniform4fv(location, 1, uniform.Floats); break;
+		case GL_FLOAT_MAT4:	glUniformMatrix4fv(location, 1, GL_FALSE, uniform.Floats); break;
+		}
+	}
+}
+
+bool Shader::Recompile(const char* vertexSource, const char* fragmentSource, const char* geometrySource)
+{
+	const char* sources[] = { vertexSource, fragmentSource, geometrySource };
+	const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER };
+	const char* names[] = { "VERTEX", "FRAGMENT", "GEOMETRY" };
+	unsigned int stages[3];
+	unsigned int stageCount = 0;
+	bool built = true;
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		if (sources[i] == nullptr)
+			continue;
+		unsigned int stage = glCreateShader(types[i]);
+		glShaderSource(stage, 1, &sources[i], NULL);
+		glCompileShader(stage);
+		built = this->checkCompileErrors(stage, names[i]) && built;
+		stages[stageCount++] = stage;
+	}
+	// link a scratch program first, a failed link would leave this program unusable
+	if (built)
+	{
+		unsigned int scratch = glCreateProgram();
+		for (unsigned int i = 0; i < stageCount; ++i)
+			glAttachShader(scratch, stages[i]);
+		glLinkProgram(scratch);
+		built = this->checkCompileErrors(scratch, "PROGRAM");
+		glDeleteProgram(scratch);
+	}
+	if (built)
+	{
+		std::vector<SavedUniform> uniforms = SaveUniforms(this->ID);
+		// swap the stages and relink the program (detaching deletes the old stages)
+		unsigned int attached[3];
+		GLsizei attachedCount = 0;
+		glGetAttachedShaders(this->ID, 3, &attachedCount, attached);
+		for (GLsizei i = 0; i < attachedCount; ++i)
+			glDetachShader(this->ID, attached[i]);
+		for (unsigned int i = 0; i < stageCount; ++i)
+			glAttachShader(this->ID, stages[i]);
+		glLinkProgram(this->ID);
+		for (unsigned int i = 0; i < stageCount; ++i)
+			glDetachShader(this->ID, stages[i]);
+		// linking resets all uniforms
+		this->Use();
+		RestoreUniforms(this->ID, uniforms);
+	}
+	for (unsigned int i = 0; i < stageCount; ++i)
+		glDeleteShader(stages[i]);
+	return built;
+}
+
 Shader &Shader::Use() 
 {
 	glUseProgram(this->ID);
@@ -131,7 +247,7 @@ void Shader::setMat4(const std::string& name, const glm::mat4& matrix, bool useS
 
 
 // check errors for compiling and linking shaders
-void Shader::checkCompileErrors(unsigned int object, std::string type)
+bool Shader::checkCompileErrors(unsigned int object, std::string type)
 {
 	int success;
 	char infoLog[1024];
@@ -158,4 +274,5 @@ void Shader::checkCompileErrors(unsigned int object, std::string type)
 				<< std::endl;
 		}
 	}
+	return success != 0;
 }
\ No newline at end of file
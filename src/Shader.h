@@ -23,6 +23,9 @@ public:
 	Shader() { }
 	// compile the shaders
 	void Compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource = nullptr);
+	// rebuild the program from new sources in place: the ID (held by every copy of this
+	// Shader) and the uniform values stay the same, nothing changes if the sources don't build
+	bool Recompile(const char* vertexSource, const char* fragmentSource, const char* geometrySource = nullptr);
 	
 	Shader &Use(); // activate the shader
 
@@ -38,7 +41,7 @@ public:
 	void setVec4(const std::string& name, float x, float y, float z, float w, bool useShader = false);
 	void setMat4(const std::string& name, const glm::mat4& matrix, bool useShader = false);
 private:
-	void checkCompileErrors(unsigned int object, std::string type);
+	bool checkCompileErrors(unsigned int object, std::string type);
 
 };
 
@@ -0,0 +1,32 @@
+#ifndef AUDIO_PLAYER_H
+#define AUDIO_PLAYER_H
+
+// sounds the game can trigger
+enum Sound
+{
+	SOUND_MUSIC,
+	SOUND_BLEEP_BRICK,
+	SOUND_BLEEP_PADDLE,
+	SOUND_SOLID,
+	SOUND_POWERUP
+};
+
+// AudioPlayer is the interface the simulation uses to trigger sounds.
+// The game itself never talks to a sound device, so it can run
+// without one (see NullAudioPlayer).
+class AudioPlayer
+{
+public:
+	virtual ~AudioPlayer() { }
+	// plays the given sound, optionally looping it
+	virtual void Play(Sound sound, bool loop = false) = 0;
+};
+
+// AudioPlayer that silently drops every sound (headless runs)
+class NullAudioPlayer : public AudioPlayer
+{
+public:
+	void Play(Sound, bool = false) override { }
+};
+
+#endif
\ No newline at end of file
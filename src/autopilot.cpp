@@ -0,0 +1,65 @@
+#include "autopilot.h"
+
+#include <algorithm>
+#include <cmath>
+
+// fractions of the paddle width the ball is caught off-center with, cycled per catch
+const float CATCH_OFFSETS[] = { 0.3f, 0.15f, 0.4f, 0.22f, 0.35f };
+const unsigned int CATCH_OFFSET_COUNT = sizeof(CATCH_OFFSETS) / sizeof(CATCH_OFFSETS[0]);
+
+Autopilot::Autopilot()
+	: catches(0), falling(false)
+{
+}
+
+void Autopilot::Control(Game& game)
+{
+	const GameObject& player = game.Player;
+	const BallObject& ball = game.Ball;
+	game.Keys[GLFW_KEY_A] = false;
+	game.Keys[GLFW_KEY_D] = false;
+	// launch right away
+	game.Keys[GLFW_KEY_SPACE] = ball.Stuck;
+	if (ball.Stuck)
+		return;
+	// count the catches (ball turned from falling to rising)
+	bool falling = ball.Velocity.y > 0.0f;
+	if (this->falling && !falling)
+		++this->catches;
+	this->falling = falling;
+	// catch the ball off-center so it is sent towards the other half of the
+	// screen, otherwise it could bounce straight up and down forever. Varying
+	// the offset per catch keeps the ball from settling into a periodic path.
+	float landing = this->PredictLanding(game);
+	float offset = player.Size.x * CATCH_OFFSETS[this->catches % CATCH_OFFSET_COUNT];
+	float target = landing < game.WorldSize().x / 2.0f ? landing - offset : landing + offset;
+	float center = player.Position.x + player.Size.x / 2.0f;
+	// small dead zone avoids jittering around the target
+	float tolerance = player.Size.x / 8.0f;
+	if (target < center - tolerance)
+		game.Keys[GLFW_KEY_A] = true;
+	else if (target > center + tolerance)
+		game.Keys[GLFW_KEY_D] = true;
+}
+
+float Autopilot::PredictLanding(const Game& game) const
+{
+	const BallObject& ball = game.Ball;
+	glm::vec2 velocity = ball.Velocity;
+	// height the ball's top-left corner has when touching the paddle
+	float landingY = game.Player.Position.y - ball.Size.y;
+	if (velocity.y == 0.0f)
+		return ball.Position.x + ball.Radius;
+	// vertical distance to travel, unfolding a bounce off the top wall
+	float distance = velocity.y > 0.0f
+		? landingY - ball.Position.y
+		: ball.Position.y + landingY;
+	float time = std::max(distance, 0.0f) / std::abs(velocity.y);
+	// unfold the side walls: the ball moves within [0, range]
+	float range = game.WorldSize().x - ball.Size.x;
+	float x = ball.Position.x + velocity.x * time;
+	x = std::fmod(std::abs(x), 2.0f * range);
+	if (x > range)
+		x = 2.0f * range - x;
+	return x + ball.Radius;
+}
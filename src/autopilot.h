@@ -0,0 +1,25 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include "game.h"
+
+// Autopilot plays the game by pressing the same keys a player would
+// (see Game::ProcessInput): it predicts where the ball will reach the
+// paddle and moves the paddle's center underneath that position.
+class Autopilot
+{
+public:
+	// constructor
+	Autopilot();
+	// sets the movement/launch keys of the game for the coming frame
+	void Control(Game& game);
+	// x-position at which the ball's center will reach the paddle
+	// (bounces off the side and top walls are folded in, bricks are ignored)
+	float PredictLanding(const Game& game) const;
+private:
+	// number of times the ball was caught, selects the catch offset
+	unsigned int catches;
+	bool falling;
+};
+
+#endif
\ No newline at end of file
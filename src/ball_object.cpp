@@ -6,8 +6,8 @@ BallObject::BallObject()
 }
 
 
-BallObject::BallObject(glm::vec2 pos, glm::vec2 velocity, float radius, Texture2D sprite)
-    : GameObject(pos,glm::vec2(radius*2.0f,radius*2.0f),sprite,glm::vec3(1.0f),velocity), Radius(radius),
+BallObject::BallObject(glm::vec2 pos, glm::vec2 velocity, float radius)
+    : GameObject(pos,glm::vec2(radius*2.0f,radius*2.0f),velocity), Radius(radius),
       Stuck(true), Sticky(false), PassThrough(false)
 {
 }
@@ -15,7 +15,7 @@ public:
 	bool	Sticky, PassThrough;
 	// constructor(s)
 	BallObject();
-	BallObject(glm::vec2 pos, glm::vec2 velocity, float radius, Texture2D sprite);
+	BallObject(glm::vec2 pos, glm::vec2 velocity, float radius);
 	// moves the ball, keeping it constrained within the window bounds
 	// (except bottom edge) return new position
 	glm::vec2 Move(float dt, unsigned int window_width);
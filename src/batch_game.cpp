@@ -0,0 +1,67 @@
+#include "batch_game.h"
+
+// number of threads to use when none is requested
+unsigned int DefaultThreads(unsigned int threads)
+{
+	if (threads > 0)
+		return threads;
+	unsigned int hardware = std::thread::hardware_concurrency();
+	return hardware > 0 ? hardware : 1;
+}
+
+BatchGame::BatchGame(unsigned int count, unsigned int width, unsigned int height, unsigned int threads, uint64_t seed)
+	: pool(DefaultThreads(threads))
+{
+	// levels are loaded once and copied into every game
+	Game prototype(width, height);
+	prototype.Particles = ParticleGenerator(0);
+	prototype.Init();
+	prototype.State = GAME_ACTIVE;
+	this->Games.assign(count, prototype);
+	for (unsigned int i = 0; i < count; ++i)
+		this->Games[i].Seed(seed + i);
+}
+
+unsigned int BatchGame::Size() const
+{
+	return static_cast<unsigned int>(this->Games.size());
+}
+
+unsigned int BatchGame::Threads() const
+{
+	return this->pool.Size();
+}
+
+void BatchGame::Step(const Action* actions, Observation* observations, float dt)
+{
+	this->pool.ParallelFor(this->Size(), [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; ++i)
+			this->stepGame(this->Games[i], actions[i], observations[i], dt);
+	});
+}
+
+void BatchGame::stepGame(Game& game, Action action, Observation& observation, float dt)
+{
+	// translate the action into the keys the game reads
+	game.Keys[GLFW_KEY_A] = action == ACTION_LEFT;
+	game.Keys[GLFW_KEY_D] = action == ACTION_RIGHT;
+	game.Keys[GLFW_KEY_SPACE] = action == ACTION_LAUNCH;
+	game.ProcessInput(dt);
+	game.Update(dt);
+	// lost all lives (back in the menu) or won: restart right away
+	observation.Done = game.State != GAME_ACTIVE;
+	if (observation.Done)
+	{
+		game.Effects.Chaos = false;
+		game.State = GAME_ACTIVE;
+	}
+	// observe
+	observation.BallPosition = game.Ball.Position;
+	observation.BallVelocity = game.Ball.Velocity;
+	observation.PlayerPosition = game.Player.Position.x;
+	observation.PlayerWidth = game.Player.Size.x;
+	observation.Lives = game.Lives;
+	observation.BricksLeft = game.Levels[game.Level].LiveBricks;
+	observation.Stuck = game.Ball.Stuck;
+}
@@ -0,0 +1,53 @@
+#ifndef BATCH_GAME_H
+#define BATCH_GAME_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game.h"
+#include "thread_pool.h"
+
+// action applied to a single game for one step
+enum Action
+{
+	ACTION_NONE,
+	ACTION_LEFT,
+	ACTION_RIGHT,
+	ACTION_LAUNCH
+};
+
+// compact state of a single game, returned after every step
+struct Observation
+{
+	glm::vec2		BallPosition, BallVelocity;
+	float			PlayerPosition, PlayerWidth;
+	unsigned int	Lives;
+	unsigned int	BricksLeft;
+	bool			Stuck;
+	bool			Done; // game was lost or won during this step and has been restarted
+};
+
+// BatchGame owns a number of independent games and advances all of them
+// at once with Step, spread over a thread pool. Games run without particles
+// and restart automatically after they are lost or won.
+class BatchGame
+{
+public:
+	// game states
+	std::vector<Game> Games;
+	// constructor (threads includes the calling thread, 0 uses all hardware threads)
+	BatchGame(unsigned int count, unsigned int width, unsigned int height, unsigned int threads = 0, uint64_t seed = 0);
+	// number of games
+	unsigned int Size() const;
+	// number of threads stepping the games
+	unsigned int Threads() const;
+	// applies actions[i] to game i, advances every game by dt and writes observations[i]
+	void Step(const Action* actions, Observation* observations, float dt);
+private:
+	ThreadPool pool;
+	// steps a single game
+	void stepGame(Game& game, Action action, Observation& observation, float dt);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "file_watcher.h"
+#include <algorithm>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher()
+	: fd(-1)
+{
+#ifdef __linux__
+	this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	if (this->fd >= 0)
+		close(this->fd);
+#endif
+}
+
+bool FileWatcher::Watch(const char* directory)
+{
+#ifdef __linux__
+	// editors either write the file in place or move a new file over it
+	int watch = this->fd >= 0 ? inotify_add_watch(this->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) : -1;
+	if (watch < 0)
+	{
+		std::cout << "ERROR::WATCHER: Failed to watch " << directory << std::endl;
+		return false;
+	}
+	this->directories[watch] = directory;
+	return true;
+#else
+	std::cout << "ERROR::WATCHER: Watching files is only supported on Linux" << std::endl;
+	return false;
+#endif
+}
+
+void FileWatcher::Poll(std::vector<std::string>& changed)
+{
+#ifdef __linux__
+	if (this->fd < 0)
+		return;
+	alignas(inotify_event) char buffer[4096];
+	ssize_t length;
+	while ((length = read(this->fd, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* next = buffer; next < buffer + length; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+			next += sizeof(inotify_event) + event->len;
+			if (event->len == 0)
+				continue;
+			std::string path = this->directories[event->wd] + "/" + event->name;
+			if (std::find(changed.begin(), changed.end(), path) == changed.end())
+				changed.push_back(path);
+		}
+	}
+#endif
+}
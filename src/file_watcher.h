@@ -0,0 +1,28 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// FileWatcher reports files that were written in a set of watched
+// directories (inotify on Linux, not available on other platforms).
+// It never blocks: Poll only collects what happened since the last call.
+class FileWatcher
+{
+public:
+	// constructor/destructor
+	FileWatcher();
+	~FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+	// starts watching the files of a directory (not recursive)
+	bool Watch(const char* directory);
+	// appends the paths (directory/name) of files written or moved in since the last call, each once
+	void Poll(std::vector<std::string>& changed);
+private:
+	int							fd;
+	std::map<int, std::string>	directories; // watch descriptor -> directory
+};
+
+#endif
\ No newline at end of file
@@ -1,102 +1,57 @@
 #include "game.h"
-#include "resource_manager.h"
-#include "sprite_renderer.h"
-#include "ball_object.h"
-#include "particle_generator.h"
-#include "post_processor.h"
-#include <irrklang/irrKlang.h>
 #include <algorithm>
-#include "text_renderer.h"
-using namespace irrklang;
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
 
 
 
-// Game-related State data
-SpriteRenderer*		Renderer;
-GameObject*			Player;
-BallObject*			Ball;
-ParticleGenerator*	Particles;
-PostProcessor*		Effects;
-ISoundEngine*		SoundEngine = createIrrKlangDevice();
-TextRenderer*		Text;
-
-float ShakeTime = 0.0f;
+// sound sink used until the frontend provides a real one (stateless, shared by all games)
+NullAudioPlayer NoAudio;
 
 Direction VectorDirection(glm::vec2 target);
 
+static_assert(std::is_trivially_copyable<GameSnapshot>::value, "GameSnapshot has to be plain data");
+
 Game::Game(unsigned int width, unsigned int height)
-	: State(GAME_MENU), Keys(), Width(width), Height(height), Level(0), Lives(3)
+	: State(GAME_MENU), Keys(), KeysProcessed(), Width(width), Height(height), Level(0), Lives(START_LIVES),
+	  PlayerAppearance{ glm::vec3(1.0f), 0.0f }, BallAppearance{ glm::vec3(1.0f), 0.0f },
+	  Particles(PARTICLE_AMOUNT), Effects(), Timers(), ShakeTimer(0), ActivePowerUps(), Random(0), Profiling(false), Phases(), CollisionBytes(0), Audio(&NoAudio)
 {
 }
 
 
 Game::~Game()
 {
-	delete Renderer;
-	delete Player;
-	delete Ball;
-	delete Particles;
-	delete Effects;
-	delete Text;
-	SoundEngine->drop();
 }
 
 void Game::Init()
 {
-	// load audio
-	SoundEngine->play2D("audio/breakout.mp3", true);
-	// load shaders
-	ResourceManager::LoadShader("shaders/sprite.vert", "shaders/sprite.frag",nullptr,"sprite");
-	ResourceManager::LoadShader("shaders/particle.vert", "shaders/particle.frag",nullptr,"particle");
-	ResourceManager::LoadShader("shaders/post_processing.vert", "shaders/post_processing.frag",nullptr,"postprocessing");
-	// configure shaders
-	glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(this->Width), 
-		static_cast<float>(this->Height), 0.0f, -1.0f, 1.0f);
-	ResourceManager::GetShader("sprite").Use();
-	ResourceManager::GetShader("sprite").setInt("image", 0);
-	ResourceManager::GetShader("sprite").setMat4("projection", projection);
-	ResourceManager::GetShader("particle").Use();
-	ResourceManager::GetShader("particle").setInt("sprite", 0);
-	ResourceManager::GetShader("particle").setMat4("projection", projection);
-	// load textures
-	ResourceManager::LoadTexture("textures/awesomeface.png", true, "face");
-	ResourceManager::LoadTexture("textures/block.png", false, "block");
-	ResourceManager::LoadTexture("textures/block_solid.png", false, "block_solid");
-	ResourceManager::LoadTexture("textures/background.jpg", false, "background");
-	ResourceManager::LoadTexture("textures/paddle.png", true, "player");
-	ResourceManager::LoadTexture("textures/particle.png", true, "particle");
-	ResourceManager::LoadTexture("textures/powerup_speed.png", true, "powerup_speed");
-	ResourceManager::LoadTexture("textures/powerup_confuse.png", true, "powerup_confuse");
-	ResourceManager::LoadTexture("textures/powerup_chaos.png", true, "powerup_chaos");
-	ResourceManager::LoadTexture("textures/powerup_increase.png", true, "powerup_increase");
-	ResourceManager::LoadTexture("textures/powerup_passthrough.png", true, "powerup_passthrough");
-	ResourceManager::LoadTexture("textures/powerup_sticky.png", true, "powerup_sticky");
-	// set render specific controls
-	Renderer = new SpriteRenderer(ResourceManager::GetShader("sprite"));
-	Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), ResourceManager::GetTexture("particle"), 2000);
-	Effects = new PostProcessor(ResourceManager::GetShader("postprocessing"), this->Width, this->Height);
-	Text = new TextRenderer(this->Width, this->Height);
-	Text->Load("resources/fonts/times.ttf",90);
-	// load levels
-	GameLevel standard; standard.Load("levels/standard.lvl", this->Width, this->Height / 2.0f);
-	GameLevel two; two.Load("levels/level_two.lvl", this->Width, this->Height / 2.0f);
-	GameLevel three; three.Load("levels/level_three.lvl", this->Width, this->Height / 2.0f);
-	GameLevel four; four.Load("levels/level_four.lvl", this->Width, this->Height / 2.0f);
-
-	this->Levels.push_back(standard);
-	this->Levels.push_back(two);
-	this->Levels.push_back(three);
-	this->Levels.push_back(four);
-	this->Level = 0;
+	// start background music
+	this->Audio->Play(SOUND_MUSIC, true);
+	// list the levels, only the first one is parsed right away (the next ones are prefetched)
+	this->Catalog.Scan("levels");
+	unsigned int count = std::max(1u, this->Catalog.Size());
+	this->Levels.assign(count + 1, GameLevel());
+	this->levelLoads.assign(count + 1, std::shared_future<GameLevel>());
+	this->levelReady.assign(count + 1, false);
+	// the endless level is generated, it is always ready
+	LevelRecipe endless = ENDLESS_RECIPE;
+	endless.Seed = this->Random.GetSeed();
+	this->Levels[count].CreateEndless(endless, this->Width, this->Height / 2);
+	this->levelReady[count] = true;
+	this->SelectLevel(0);
 
 	//configure game objects
-	glm::vec2 playerPos = glm::vec2(this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, this->Height - PLAYER_SIZE.y);
+	glm::vec2 world = this->WorldSize();
+	glm::vec2 playerPos = glm::vec2(world.x / 2.0f - PLAYER_SIZE.x / 2.0f, world.y - PLAYER_SIZE.y);
 
-	Player = new GameObject(playerPos, PLAYER_SIZE, ResourceManager::GetTexture("player"));
+	this->Player = GameObject(playerPos, PLAYER_SIZE);
 
 	glm::vec2 ballPos = playerPos + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -BALL_RADIUS * 2.0f);
 
-	Ball = new BallObject(ballPos, BALL_VELOCITY, BALL_RADIUS, ResourceManager::GetTexture("face"));
+	this->Ball = BallObject(ballPos, BALL_VELOCITY, BALL_RADIUS);
 }
 
 void Game::ProcessInput(float dt)
@@ -110,15 +65,12 @@ void Game::ProcessInput(float dt)
 		}
 		if (this->Keys[GLFW_KEY_W] && !this->KeysProcessed[GLFW_KEY_W])
 		{
-			this->Level = (this->Level + 1) % 4;
+			this->SelectLevel((this->Level + 1) % this->Levels.size());
 			this->KeysProcessed[GLFW_KEY_W] = true;
 		}
 		if (this->Keys[GLFW_KEY_S] && !this->KeysProcessed[GLFW_KEY_S])
 		{
-			if (this->Level > 0)
-				--this->Level;
-			else
-				this->Level = 3;
+			this->SelectLevel((this->Level + this->Levels.size() - 1) % this->Levels.size());
 			this->KeysProcessed[GLFW_KEY_S] = true;
 		}
 	}
@@ -127,29 +79,29 @@ void Game::ProcessInput(float dt)
 		float velocity = PLAYER_VELOCITY * dt;
 		if (this->Keys[GLFW_KEY_A])
 		{
-			if (Player->Position.x >= 0.0f)
+			if (this->Player.Position.x >= 0.0f)
 			{
-				Player->Position.x -= velocity;
-				if (Ball->Stuck)
-					Ball->Position.x -= velocity;
+				this->Player.Position.x -= velocity;
+				if (this->Ball.Stuck)
+					this->Ball.Position.x -= velocity;
 			}
 		}
 		if (this->Keys[GLFW_KEY_D])
-			if (Player->Position.x <= this->Width - Player->Size.x)
+			if (this->Player.Position.x <= this->WorldSize().x - this->Player.Size.x)
 			{
-				Player->Position.x += velocity;
-				if (Ball->Stuck)
-					Ball->Position.x += velocity;
+				this->Player.Position.x += velocity;
+				if (this->Ball.Stuck)
+					this->Ball.Position.x += velocity;
 			}
 		if (this->Keys[GLFW_KEY_SPACE])
-			Ball->Stuck = false;
+			this->Ball.Stuck = false;
 	}
 	if (this->State == GAME_WIN)
 	{
 		if (this->Keys[GLFW_KEY_LEFT_ALT])
 		{
 			this->KeysProcessed[GLFW_KEY_LEFT_ALT] = true;
-			Effects->Chaos = false;
+			this->Effects.Chaos = false;
 			this->State = GAME_MENU;
 		}
 	}
@@ -157,23 +109,34 @@ void Game::ProcessInput(float dt)
 
 void Game::Update(float dt)
 {
+	PhaseTimer timer(this->Profiling);
+	glm::vec2 world = this->WorldSize();
 	// update objects
-	Ball->Move(dt, this->Width);
+	this->Ball.Move(dt, static_cast<unsigned int>(world.x));
+	// the rows of the endless level move down while the ball is in play
+	if (this->State == GAME_ACTIVE && !this->Ball.Stuck)
+		this->Levels[this->Level].Descend(ENDLESS_SPEED * dt);
+	this->Phases.Move = timer.Lap();
+	// page the chunks of a chunked level in around the ball and the camera
+	glm::vec2 view = this->ViewPosition();
+	this->Levels[this->Level].Stream(this->Ball.Position, this->Ball.Position + this->Ball.Size,
+		view, view + glm::vec2(this->Width, this->Height));
+	this->Phases.Streaming = timer.Lap();
 	// check for collisions
 	this->DoCollisions();
+	this->Phases.Collisions = timer.Lap();
+	// apply what the collisions caused (sounds, power-ups, effects)
+	this->DispatchEvents();
+	this->Phases.Events = timer.Lap();
 	// update particle system
-	Particles->Update(dt, *Ball, 4, glm::vec2(Ball->Radius / 2.0f));
-	// update PowerUps
+	this->Particles.Update(dt, this->Ball, 4, this->Random.Visual, glm::vec2(this->Ball.Radius / 2.0f));
+	this->Phases.Particles = timer.Lap();
+	// update PowerUps and timed effects
 	this->UpdatePowerUps(dt);
-	// reduce shake time
-	if (ShakeTime > 0.0f)
-	{
-		ShakeTime -= dt;
-		if (ShakeTime <= 0.0f)
-			Effects->Shake = false;
-	}
+	this->UpdateTimers(dt);
+	this->Phases.PowerUps = timer.Lap();
 	// check loss condition
-	if (Ball->Position.y >= this->Height) // did ball reach the bottom edge?
+	if (this->Ball.Position.y >= world.y) // did ball reach the bottom edge?
 	{
 		--this->Lives;
 		// did the player lose all his lives? : Game over
@@ -188,73 +151,29 @@ void Game::Update(float dt)
 	{
 		this->ResetLevel();
 		this->ResetPlayer();
-		Effects->Chaos = true;
+		this->Effects.Chaos = true;
 		this->State = GAME_WIN;
 	}
 }
 
-void Game::Render()
-{
-	if (this->State == GAME_ACTIVE || this->State == GAME_MENU || this->State == GAME_WIN)
-	{
-		// begin rendering to postprocessing framebuffer
-		Effects->BeginRender();
-		// draw background
-		Renderer->DrawSprite(ResourceManager::GetTexture("background"), glm::vec2(0.0f, 0.0f),
-			glm::vec2(this->Width, this->Height));
-		// draw level
-		this->Levels[this->Level].Draw(*Renderer);
-		// draw player
-		Player->Draw(*Renderer);
-		// draw powerUps
-		for (PowerUP& powerUp : this->PowerUps)
-			if (!powerUp.Destroyed)
-				powerUp.Draw(*Renderer);
-		// draw particles
-		if (!Ball->Stuck)
-			Particles->Draw();
-		// draw ball
-		Ball->Draw(*Renderer);
-		// end rendering to postprocessing framebuffer
-		Effects->EndRender();
-		// render postprocessing quad
-		Effects->Render(glfwGetTime());
-		// render text (don't include in postprocessing)
-		std::stringstream ss1, ss2; ss1 << this->Lives; ss2 << this->Level;
-		Text->RenderText("Lives: " + ss1.str(), 15.0f, 15.0f, 1.0f);
-		Text->RenderText("Level: " + ss2.str(), 2100.0f, 15.0f, 1.0f);
-	}
-	if (this->State == GAME_MENU)
-	{
-		Text->RenderText("Press SPACE to start", 900.0f, this->Height / 2.0f + 5.0f, 0.8f);
-		Text->RenderText("Press W or S to select level", 800.0f, this->Height / 2.0f + 80.0f, 0.8f);
-	}
-	if (this->State == GAME_WIN)
-	{
-		Text->RenderText("You WON", 900.0f, this->Height / 2.0f, 1.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-		Text->RenderText("Press LEFT_ALT to retry or ESC to quit", 400.0f, this->Height / 2.0f + 75.0f, 1.0f, glm::vec3(1.0f, 1.0f, 0.0f));
-	}
-}
-
-
-bool Game::CheckCollision(GameObject& one, GameObject& two)
+bool Game::CheckCollision(const GameObject& one, glm::vec2 position, glm::vec2 size)
 {
 	// collision x-axis
-	bool collisionX = one.Position.x + one.Size.x >= two.Position.x &&
-		two.Position.x + two.Size.x >= one.Position.x;
+	bool collisionX = one.Position.x + one.Size.x >= position.x &&
+		position.x + size.x >= one.Position.x;
 	// collision y-axis
-	bool collisionY = one.Position.y + one.Size.y >= two.Position.y &&
-		two.Position.y + two.Size.y >= one.Position.y;
+	bool collisionY = one.Position.y + one.Size.y >= position.y &&
+		position.y + size.y >= one.Position.y;
 	return collisionX && collisionY;
 }
 
 
-Collision Game::CheckCollision(BallObject& ball, GameObject& obj)
+Collision Game::CheckCollision(const BallObject& ball, glm::vec2 position, glm::vec2 size)
 {
 	// calculate the centers of shapes
 	glm::vec2 circleCenter(ball.Position + ball.Radius);
-	glm::vec2 aabb_half_extents(obj.Size.x / 2.0f, obj.Size.y / 2.0f);
-	glm::vec2 aabb_center(obj.Position + aabb_half_extents);
+	glm::vec2 aabb_half_extents(size.x / 2.0f, size.y / 2.0f);
+	glm::vec2 aabb_center(position + aabb_half_extents);
 	// get difference vector between both centers
 	glm::vec2 difference = circleCenter - aabb_center;
 	glm::vec2 clamped = glm::clamp(difference, -aabb_half_extents, aabb_half_extents);
@@ -268,157 +187,468 @@ Collision Game::CheckCollision(BallObject& ball, GameObject& obj)
 	return std::make_tuple(false, UP, glm::vec2(0.0f, 0.0f));
 }
 
-void ActivatePowerUp(PowerUP& powerUP)
+void Game::ActivatePowerUp(PowerUpType type)
 {
-	if (powerUP.Type == "speed")
-	{
-		Ball->Velocity *= 1.2f;
-	}
-	else if (powerUP.Type == "sticky")
-	{
-		Ball->Sticky = true;
-		Player->Colour = glm::vec3(1.0f, 0.5f, 1.0f);
-	}
-	else if (powerUP.Type == "pass_through")
-	{
-		Ball->PassThrough = true;
-		Ball->Colour = glm::vec3(1.0f, 0.5f, 0.5f);
-	}
-	else if (powerUP.Type == "pad-size-increase")
+	const PowerUpKind& kind = POWERUP_KINDS[type];
+	kind.Activate(*this);
+	// effects with a duration are disabled again by a timer
+	if (kind.Duration > 0.0f)
 	{
-		Player->Size.x += 100.0f;
+		++this->ActivePowerUps[type];
+		this->Timers.Schedule(kind.Duration, TIMER_POWERUP_EXPIRED, type);
 	}
-	else if (powerUP.Type == "confuse")
+}
+
+void Game::DeactivatePowerUp(PowerUpType type)
+{
+	// only disable the effect once no other PowerUp of the same kind is still active
+	if (--this->ActivePowerUps[type] == 0 && POWERUP_KINDS[type].Deactivate)
+		POWERUP_KINDS[type].Deactivate(*this);
+}
+
+// converts circle/box collision data into a contact (normal pointing from the brick towards the ball)
+Contact MakeContact(BallObject& ball, Collision& collision)
+{
+	Direction dir = std::get<1>(collision);
+	glm::vec2 diff_vect = std::get<2>(collision);
+	if (dir == LEFT || dir == RIGHT) // horizontal collision
+		return { glm::vec2(dir == LEFT ? 1.0f : -1.0f, 0.0f), ball.Radius - std::abs(diff_vect.x) };
+	return { glm::vec2(0.0f, dir == UP ? -1.0f : 1.0f), ball.Radius - std::abs(diff_vect.y) };
+}
+
+// stores a contact, if the buffer is full the shallowest contact is replaced
+void AddContact(Contact* contacts, unsigned int& count, Contact contact)
+{
+	if (count < MAX_CONTACTS)
 	{
-		Effects->Chaos = false;
-		Effects->Confuse = true; // first - disable chaos, than confuse
+		contacts[count++] = contact;
+		return;
 	}
-	else if (powerUP.Type == "chaos")
+	unsigned int shallowest = 0;
+	for (unsigned int i = 1; i < count; ++i)
+		if (contacts[i].Penetration < contacts[shallowest].Penetration)
+			shallowest = i;
+	if (contact.Penetration > contacts[shallowest].Penetration)
+		contacts[shallowest] = contact;
+}
+
+// resolves all contacts of a step at once: normals are merged so that a seam between two
+// bricks reflects the ball a single time and corners reflect both axes, the ball is pushed
+// out by the deepest penetration per axis instead of once per brick
+void ResolveContacts(BallObject& ball, Contact* contacts, unsigned int count)
+{
+	// merged normal, opposing contacts on the same axis cancel out (ball is squeezed and keeps its course)
+	glm::vec2 normal(0.0f);
+	for (unsigned int i = 0; i < count; ++i)
+		normal += contacts[i].Normal;
+	normal = glm::sign(normal);
+	// deepest penetration of the contacts agreeing with the merged normal
+	glm::vec2 penetration(0.0f);
+	for (unsigned int i = 0; i < count; ++i)
 	{
-		Effects->Confuse = false;
-		Effects->Chaos = true; // first - disable confuse, than chaos
+		const Contact& contact = contacts[i];
+		if (contact.Normal.x != 0.0f && contact.Normal.x == normal.x)
+			penetration.x = std::max(penetration.x, contact.Penetration);
+		if (contact.Normal.y != 0.0f && contact.Normal.y == normal.y)
+			penetration.y = std::max(penetration.y, contact.Penetration);
 	}
-
+	// only reflect when moving into the contact, otherwise a second contact would undo the bounce
+	if (ball.Velocity.x * normal.x < 0.0f)
+		ball.Velocity.x *= -1;
+	if (ball.Velocity.y * normal.y < 0.0f)
+		ball.Velocity.y *= -1;
+	// relocate
+	ball.Position += normal * penetration;
 }
 
 void Game::DoCollisions()
 {
-	for (GameObject& box : this->Levels[this->Level].Bricks)
+	// contacts of this step, the ball can only overlap a handful of bricks at once
+	Contact contacts[MAX_CONTACTS];
+	unsigned int contactCount = 0;
+	// only bricks in the neighbourhood of the ball are tested: the bitmap words of the
+	// rows it covers and the tile codes of live bricks, positions follow from the grid
+	GameLevel& level = this->Levels[this->Level];
+	unsigned int tested = 0;
+	unsigned int words = level.ForEachLiveIn(this->Ball.Position, this->Ball.Position + this->Ball.Size, [&](unsigned int cell)
 	{
-		if (!box.Destroyed)
+		++tested;
+		Collision collision = CheckCollision(this->Ball, level.BrickPosition(cell), level.BrickSize);
+		if (std::get<0>(collision)) // if collision is true
 		{
-			Collision collision = CheckCollision(*Ball, box);
-			if (std::get<0>(collision)) // if collision is true
+			bool solid = level.IsSolid(cell);
+			// destroy block if not solid, everything else happens when the events are dispatched
+			if (!solid)
 			{
-				// destroy block if not solid
-				if (!box.IsSolid)
-				{
-					SoundEngine->play2D("audio/bleep.mp3", false);
-					box.Destroyed = true;
-					this->SpawnPowerUps(box);
-				}
-				else
-				{
-					SoundEngine->play2D("audio/solid.wav", false);
-					// if block is solid, enable shake effect
-					ShakeTime = 0.05f;
-					Effects->Shake = true;
-				}
-				// collision resolution
-				Direction dir = std::get<1>(collision);
-				glm::vec2 diff_vect = std::get<2>(collision);
-				if (!Ball->PassThrough || box.IsSolid)
-				{
-					if (dir == LEFT || dir == RIGHT) // horizontal collision
-					{
-						Ball->Velocity.x *= -1; // reverse horizontal velocity
-						// relocate
-						float penetration = Ball->Radius - std::abs(diff_vect.x);
-						if (dir == LEFT)
-							Ball->Position.x += penetration; // to right
-						else
-							Ball->Position.x -= penetration; // to left
-					}
-					else
-					{
-						Ball->Velocity.y *= -1; // reverse vertical velocity
-						// relocate
-						float penetration = Ball->Radius - std::abs(diff_vect.y);
-						if (dir == UP)
-							Ball->Position.y -= penetration; // back up
-						else
-							Ball->Position.y += penetration; // back down
-					}
-				}
+				level.Destroy(cell);
+				this->emit({ EVENT_BRICK_DESTROYED, 0, cell });
 			}
+			else
+				this->emit({ EVENT_SOLID_HIT, 0, cell });
+			// gather contact, resolution happens once all bricks were tested
+			if (!this->Ball.PassThrough || solid)
+				AddContact(contacts, contactCount, MakeContact(this->Ball, collision));
 		}
-	}
+	});
+	// collision resolution
+	ResolveContacts(this->Ball, contacts, contactCount);
 
 	// also check collisions on PowerUps and if so, activate them 
 	for (PowerUP& powerUP : this->PowerUps)
 	{
 		if (!powerUP.Destroyed)
 		{
-			if (powerUP.Position.y >= this->Height)
+			if (powerUP.Position.y >= this->WorldSize().y)
 				powerUP.Destroyed = true;
-			if (this->CheckCollision(*Player, powerUP))
+			if (this->CheckCollision(this->Player, powerUP.Position, POWERUP_SIZE))
 			{
-				SoundEngine->play2D("audio/powerup.wav", false);
-				ActivatePowerUp(powerUP);
-				powerUP.Activated = true;
+				// activated right away so the paddle check below sees a sticky ball or a
+				// bigger paddle collected this frame, the event only plays the sound
+				this->ActivatePowerUp(powerUP.Type);
+				this->emit({ EVENT_POWERUP_COLLECTED, static_cast<uint8_t>(powerUP.Type), 0 });
 				powerUP.Destroyed = true;
 			}
 		}
 	}
+	this->CollisionBytes = words * sizeof(uint64_t) + tested * sizeof(uint8_t)
+		+ this->PowerUps.Size() * sizeof(PowerUP) + sizeof(this->Player) + sizeof(this->Ball);
 
 	// check collisions for player pad (unless stuck)
-	Collision result = CheckCollision(*Ball, *Player);
-	if (!Ball->Stuck && std::get<0>(result))
+	Collision result = CheckCollision(this->Ball, this->Player.Position, this->Player.Size);
+	if (!this->Ball.Stuck && std::get<0>(result))
 	{
-		SoundEngine->play2D("audio/bleep.wav", false);
+		this->emit({ EVENT_PADDLE_HIT, 0, 0 });
 		// check where it hit the board, and change velocity based on where it hit the board
-		float centerBoardX = Player->Position.x + Player->Size.x / 2.0f;
-		float distance = (Ball->Position.x + Ball->Radius) - centerBoardX;
-		float percentage = distance / (Player->Size.x / 2.0f);
+		float centerBoardX = this->Player.Position.x + this->Player.Size.x / 2.0f;
+		float distance = (this->Ball.Position.x + this->Ball.Radius) - centerBoardX;
+		float percentage = distance / (this->Player.Size.x / 2.0f);
 		// then move accordingly
 		float strength = 2.0f;
-		glm::vec2 oldVelocity = Ball->Velocity;
-		Ball->Velocity.x = (BALL_VELOCITY.x + 300.0f) * percentage * strength;
+		glm::vec2 oldVelocity = this->Ball.Velocity;
+		this->Ball.Velocity.x = (BALL_VELOCITY.x + 300.0f) * percentage * strength;
 		// keep speed consistent over both axes (multiply by length of old velocity, so total strength is not changed)
-		Ball->Velocity = glm::normalize(Ball->Velocity) * glm::length(oldVelocity);
+		this->Ball.Velocity = glm::normalize(this->Ball.Velocity) * glm::length(oldVelocity);
 		// fix sticky paddle
-		Ball->Velocity.y = -1.0f * std::abs(Ball->Velocity.y);
+		this->Ball.Velocity.y = -1.0f * std::abs(this->Ball.Velocity.y);
 
 		// if Sticky powerup is activated, also stick ball to paddle once new velocity velocity vectors
 		// were calculated
-		Ball->Stuck = Ball->Sticky;
+		this->Ball.Stuck = this->Ball.Sticky;
+	}
+}
+
+// sound played for each type of event
+const Sound EVENT_SOUNDS[EVENT_TYPE_COUNT] =
+{
+	SOUND_BLEEP_BRICK,	// EVENT_BRICK_DESTROYED
+	SOUND_SOLID,		// EVENT_SOLID_HIT
+	SOUND_BLEEP_PADDLE,	// EVENT_PADDLE_HIT
+	SOUND_POWERUP		// EVENT_POWERUP_COLLECTED
+};
+
+void Game::emit(GameEvent event)
+{
+	// the queue only overflows when the ball covers a lot of tiny bricks at once,
+	// dispatching early keeps every event (brick order is kept either way)
+	if (!this->Events.Push(event))
+	{
+		this->DispatchEvents();
+		this->Events.Push(event);
 	}
 }
 
+void Game::DispatchEvents()
+{
+	GameLevel& level = this->Levels[this->Level];
+	unsigned int counts[EVENT_TYPE_COUNT] = {};
+	// gameplay first, in the order the events happened (keeps the power-up rolls in brick order);
+	// collected power-ups were already activated by DoCollisions
+	for (unsigned int i = 0; i < this->Events.Size(); ++i)
+	{
+		const GameEvent& event = this->Events[i];
+		++counts[event.Type];
+		if (event.Type == EVENT_BRICK_DESTROYED)
+		{
+			for (BrickDestroyedListener& listener : this->BrickDestroyedListeners)
+				listener(level, event.Cell);
+			this->SpawnPowerUps(level.BrickPosition(event.Cell));
+		}
+	}
+	// effects: any number of solid hits starts a single shake (replacing the running one)
+	if (counts[EVENT_SOLID_HIT] > 0)
+	{
+		this->ShakeTimer = this->Timers.Schedule(SHAKE_DURATION, TIMER_SHAKE_ENDED);
+		this->Effects.Shake = true;
+	}
+	// audio: each sound is played once per batch, however often it was triggered
+	for (unsigned int type = 0; type < EVENT_TYPE_COUNT; ++type)
+		if (counts[type] > 0)
+			this->Audio->Play(EVENT_SOUNDS[type]);
+	this->Events.Clear();
+}
+
+void Game::OnBrickDestroyed(BrickDestroyedListener listener)
+{
+	this->BrickDestroyedListeners.push_back(listener);
+}
+
+glm::vec2 Game::WorldSize() const
+{
+	// the bricks take the top of the playfield, half a screen of space is left below them
+	glm::vec2 screen(this->Width, this->Height);
+	if (this->Levels.empty())
+		return screen;
+	return glm::max(this->Levels[this->Level].Size() + glm::vec2(0.0f, screen.y / 2.0f), screen);
+}
+
+glm::vec2 Game::ViewPosition() const
+{
+	// center the ball, but never show anything outside of the playfield
+	glm::vec2 screen(this->Width, this->Height);
+	glm::vec2 view = this->Ball.Position + this->Ball.Radius - screen / 2.0f;
+	return glm::clamp(view, glm::vec2(0.0f), this->WorldSize() - screen);
+}
+
+void Game::SelectLevel(unsigned int index)
+{
+	this->Level = index;
+	this->loadLevel(index);
+	// the playfield may have changed size
+	this->ResetPlayer();
+	// the menu moves one level up or down
+	unsigned int count = static_cast<unsigned int>(this->Levels.size());
+	this->PrefetchLevel((index + 1) % count);
+	this->PrefetchLevel((index + count - 1) % count);
+}
+
+void Game::loadLevel(unsigned int index)
+{
+	if (this->levelReady[index])
+		return;
+	// waits only if the prefetch did not finish yet
+	this->PrefetchLevel(index);
+	if (this->levelLoads[index].valid())
+		this->Levels[index] = this->levelLoads[index].get();
+	this->levelLoads[index] = std::shared_future<GameLevel>();
+	this->levelReady[index] = true;
+}
+
+void Game::PrefetchLevel(unsigned int index)
+{
+	if (this->levelReady[index] || this->levelLoads[index].valid() || index >= this->Catalog.Size())
+		return;
+	std::string path = this->Catalog.Levels[index].Path;
+	unsigned int width = this->Width, height = this->Height / 2;
+	this->levelLoads[index] = std::async(std::launch::async, [path, width, height]()
+	{
+		GameLevel level;
+		level.Load(path.c_str(), width, height);
+		return level;
+	}).share();
+}
+
+bool Game::ReloadLevel(const std::string& path)
+{
+	int index = this->Catalog.Find(path);
+	if (index < 0)
+		return false;
+	// a pending prefetch may have read the old file, start it over
+	if (this->levelLoads[index].valid())
+	{
+		this->levelLoads[index] = std::shared_future<GameLevel>();
+		this->PrefetchLevel(index);
+		return true;
+	}
+	// levels that were never parsed pick up the change once they are
+	if (!this->levelReady[index])
+		return false;
+	// parse into a scratch level, a broken file keeps the level as it was
+	GameLevel level;
+	level.Load(this->Catalog.Levels[index].Path.c_str(), this->Width, this->Height / 2);
+	if (level.Columns == 0)
+	{
+		std::cout << "ERROR::LEVEL: Failed to reload " << path << ", keeping the previous level" << std::endl;
+		return false;
+	}
+	this->Levels[index] = std::move(level);
+	if (index == static_cast<int>(this->Level))
+		this->ResetPlayer();
+	return true;
+}
+
 void Game::ResetLevel()
 {
-	if (this->Level == 0)
-		this->Levels[Level].Load("levels/standard.lvl", this->Width, this->Height/2);
-	if (this->Level == 1)
-		this->Levels[Level].Load("levels/level_two.lvl", this->Width, this->Height / 2);
-	if (this->Level == 2)
-		this->Levels[Level].Load("levels/level_three.lvl", this->Width, this->Height / 2);
-	if (this->Level == 3)
-		this->Levels[Level].Load("levels/level_four.lvl", this->Width, this->Height / 2);
-	this->Lives = 3;
+	// restore the bricks from the copy kept at load time
+	this->Levels[this->Level].Reset();
+	this->Lives = START_LIVES;
+}
+
+void Game::Seed(uint64_t seed)
+{
+	this->Random.Seed(seed);
+	// the rows of the endless level are drawn from the seed as well
+	if (!this->Levels.empty() && this->Levels.back().Endless)
+	{
+		this->Levels.back().Recipe.Seed = seed;
+		this->Levels.back().Reset();
+	}
+}
+
+void Game::Save(std::vector<uint8_t>& snapshot) const
+{
+	const GameLevel& level = this->Levels[this->Level];
+	size_t timers = this->Timers.Timers.size() * sizeof(Timer);
+	snapshot.resize(sizeof(GameSnapshot) + timers + level.StateSize());
+	// value initialized, so the padding bytes are zero as well
+	GameSnapshot header{};
+	header.Size = static_cast<uint32_t>(snapshot.size());
+	header.Level = this->Level;
+	header.State = this->State;
+	header.Lives = this->Lives;
+	std::copy(std::begin(this->Keys), std::end(this->Keys), header.Keys);
+	std::copy(std::begin(this->KeysProcessed), std::end(this->KeysProcessed), header.KeysProcessed);
+	header.Player = this->Player;
+	header.Ball = this->Ball;
+	header.PlayerAppearance = this->PlayerAppearance;
+	header.BallAppearance = this->BallAppearance;
+	header.Effects = this->Effects;
+	header.PowerUps = this->PowerUps;
+	header.Events = this->Events;
+	std::copy(std::begin(this->ActivePowerUps), std::end(this->ActivePowerUps), header.ActivePowerUps);
+	header.ShakeTimer = this->ShakeTimer;
+	header.Random = this->Random.Save();
+	header.Now = this->Timers.Now;
+	header.NextTimerId = this->Timers.NextId;
+	header.TimerCount = static_cast<uint32_t>(this->Timers.Timers.size());
+	header.Bricks = level.SaveState(snapshot.data() + sizeof(GameSnapshot) + timers);
+	std::memcpy(snapshot.data(), &header, sizeof(header));
+	// an empty heap has no storage, memcpy must not be handed its null pointer
+	if (timers > 0)
+		std::memcpy(snapshot.data() + sizeof(header), this->Timers.Timers.data(), timers);
+}
+
+// true if every flag holds 0 or 1, read as bytes (a snapshot read from a file can hold anything)
+bool ValidFlags(const bool* flags, size_t count)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(flags);
+	return std::all_of(bytes, bytes + count, [](unsigned char byte) { return byte <= 1; });
+}
+
+// value of an enum read as its bytes, in range or not
+template <typename E>
+uint32_t RawEnum(const E& value)
+{
+	std::underlying_type_t<E> raw;
+	std::memcpy(&raw, &value, sizeof(raw));
+	return static_cast<uint32_t>(raw);
+}
+
+bool Finite(glm::vec2 value)
+{
+	return std::isfinite(value.x) && std::isfinite(value.y);
+}
+
+bool ValidObject(const GameObject& object)
+{
+	return Finite(object.Position) && Finite(object.Size) && Finite(object.Velocity)
+		&& ValidFlags(&object.IsSolid, 1) && ValidFlags(&object.Destroyed, 1);
+}
+
+// true if the state of a snapshot (header and timers) is in range for a game playing
+// level: enums, flags, counters and indices the step functions rely on
+bool ValidSnapshot(const GameSnapshot& header, const uint8_t* timers, const GameLevel& level)
+{
+	if (RawEnum(header.State) > GAME_WIN || header.Lives > START_LIVES
+		|| !ValidFlags(header.Keys, std::size(header.Keys)) || !ValidFlags(header.KeysProcessed, std::size(header.KeysProcessed))
+		|| !ValidObject(header.Player) || !ValidObject(header.Ball) || !std::isfinite(header.Ball.Radius)
+		|| !ValidFlags(&header.Ball.Stuck, 1) || !ValidFlags(&header.Ball.Sticky, 1) || !ValidFlags(&header.Ball.PassThrough, 1)
+		|| !ValidFlags(&header.Effects.Confuse, 1) || !ValidFlags(&header.Effects.Chaos, 1) || !ValidFlags(&header.Effects.Shake, 1)
+		|| !std::isfinite(header.Now) || !header.PowerUps.Valid() || !header.Events.Valid())
+		return false;
+	for (const PowerUP& powerUp : header.PowerUps)
+		if (RawEnum(powerUp.Type) >= POWERUP_TYPE_COUNT || !ValidFlags(&powerUp.Destroyed, 1) || !Finite(powerUp.Position))
+			return false;
+	size_t cells = static_cast<size_t>(level.Columns) * level.Rows;
+	for (unsigned int i = 0; i < header.Events.Size(); ++i)
+		if (header.Events[i].Type >= EVENT_TYPE_COUNT || header.Events[i].PowerUp >= POWERUP_TYPE_COUNT || header.Events[i].Cell >= cells)
+			return false;
+	// the timers have to form a heap, payloads of power-up timers index the kinds
+	Timer timer, parent;
+	for (uint32_t i = 0; i < header.TimerCount; ++i)
+	{
+		std::memcpy(&timer, timers + i * sizeof(Timer), sizeof(Timer));
+		if (!std::isfinite(timer.Expiry) || RawEnum(timer.Event) > TIMER_SHAKE_ENDED
+			|| (timer.Event == TIMER_POWERUP_EXPIRED && timer.Payload >= POWERUP_TYPE_COUNT))
+			return false;
+		if (i > 0)
+		{
+			std::memcpy(&parent, timers + (i - 1) / 2 * sizeof(Timer), sizeof(Timer));
+			if (TimerQueue::TimerLater(parent, timer))
+				return false;
+		}
+	}
+	return true;
+}
+
+bool Game::Restore(const std::vector<uint8_t>& snapshot)
+{
+	GameSnapshot header;
+	if (snapshot.size() < sizeof(header))
+		return false;
+	std::memcpy(&header, snapshot.data(), sizeof(header));
+	size_t timers = static_cast<size_t>(header.TimerCount) * sizeof(Timer);
+	if (header.Size != snapshot.size() || header.Level >= this->Levels.size() || snapshot.size() - sizeof(header) < timers)
+		return false;
+	// the snapshot has to fit the level it names before anything changes
+	this->loadLevel(header.Level);
+	size_t bricks = snapshot.size() - sizeof(header) - timers;
+	if (!this->Levels[header.Level].FitsState(header.Bricks, snapshot.data() + sizeof(header) + timers, bricks)
+		|| !ValidSnapshot(header, snapshot.data() + sizeof(header), this->Levels[header.Level]))
+		return false;
+	if (header.Level != this->Level)
+	{
+		// player and ball come from the snapshot, so the level is switched without a reset
+		unsigned int count = static_cast<unsigned int>(this->Levels.size());
+		this->Level = header.Level;
+		this->PrefetchLevel((header.Level + 1) % count);
+		this->PrefetchLevel((header.Level + count - 1) % count);
+	}
+	this->Levels[this->Level].RestoreState(header.Bricks, snapshot.data() + sizeof(header) + timers, bricks);
+	this->State = header.State;
+	this->Lives = header.Lives;
+	std::copy(std::begin(header.Keys), std::end(header.Keys), this->Keys);
+	std::copy(std::begin(header.KeysProcessed), std::end(header.KeysProcessed), this->KeysProcessed);
+	this->Player = header.Player;
+	this->Ball = header.Ball;
+	this->PlayerAppearance = header.PlayerAppearance;
+	this->BallAppearance = header.BallAppearance;
+	this->Effects = header.Effects;
+	this->PowerUps = header.PowerUps;
+	this->Events = header.Events;
+	std::copy(std::begin(header.ActivePowerUps), std::end(header.ActivePowerUps), this->ActivePowerUps);
+	this->ShakeTimer = header.ShakeTimer;
+	this->Random.Restore(header.Random);
+	this->Timers.Now = header.Now;
+	this->Timers.NextId = header.NextTimerId;
+	// keeps the capacity of the heap, restoring does not allocate once it is large enough
+	this->Timers.Timers.resize(header.TimerCount);
+	if (timers > 0)
+		std::memcpy(this->Timers.Timers.data(), snapshot.data() + sizeof(header), timers);
+	return true;
 }
 
 void Game::ResetPlayer()
 {
 	// reset player/ball state
-	Player->Size = PLAYER_SIZE;
-	Player->Position = glm::vec2(this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, this->Height - PLAYER_SIZE.y);
-	Ball->Reset(Player->Position + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -2.0f * BALL_RADIUS), BALL_VELOCITY);
+	this->Player.Size = PLAYER_SIZE;
+	glm::vec2 world = this->WorldSize();
+	this->Player.Position = glm::vec2(world.x / 2.0f - PLAYER_SIZE.x / 2.0f, world.y - PLAYER_SIZE.y);
+	this->Ball.Reset(this->Player.Position + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -2.0f * BALL_RADIUS), BALL_VELOCITY);
 
-	Effects->Chaos = Effects->Confuse = false;
-	Ball->PassThrough = Ball->Sticky = false;
-	Ball->Colour = glm::vec3(1.0f);
-	Player->Colour = glm::vec3(1.0f);
+	this->Effects.Chaos = this->Effects.Confuse = false;
+	this->Ball.PassThrough = this->Ball.Sticky = false;
+	this->BallAppearance.Colour = glm::vec3(1.0f);
+	this->PlayerAppearance.Colour = glm::vec3(1.0f);
 
 }
 
@@ -446,77 +676,41 @@ Direction VectorDirection(glm::vec2 target)
 	return (Direction)best_match;
 }
 
-bool ShouldSpawn(unsigned int chance)
+bool ShouldSpawn(RandomStream& random, unsigned int chance)
 {
-	unsigned int random = rand() % chance;
-	return random == 0;
+	return random.Below(chance) == 0;
 }
 
-void Game::SpawnPowerUps(GameObject& block)
+void Game::SpawnPowerUps(glm::vec2 position)
 {
-	if (ShouldSpawn(75))
-		this->PowerUps.push_back(PowerUP("speed", glm::vec3(0.5f, 0.5f, 1.0f), 0.0f, block.Position, ResourceManager::GetTexture("powerup_speed")));
-	if (ShouldSpawn(75))
-		this->PowerUps.push_back(PowerUP("sticky", glm::vec3(1.0f, 0.5f, 1.0f), 20.0f, block.Position, ResourceManager::GetTexture("powerup_sticky")));
-	if (ShouldSpawn(75))
-		this->PowerUps.push_back(PowerUP("pass_through", glm::vec3(0.5f, 1.0f, 0.5f), 10.0f, block.Position, ResourceManager::GetTexture("powerup_passthrough")));
-	if (ShouldSpawn(75))
-		this->PowerUps.push_back(PowerUP("pad-size-increase", glm::vec3(1.0f,0.6f, 0.4f), 0.0f, block.Position, ResourceManager::GetTexture("powerup_increase")));
-	if (ShouldSpawn(15))
-		this->PowerUps.push_back(PowerUP("confuse", glm::vec3(1.0f, 0.3f, 0.3f), 15.0f, block.Position, ResourceManager::GetTexture("powerup_confuse")));
-	if (ShouldSpawn(15))
-		this->PowerUps.push_back(PowerUP("chaos", glm::vec3(0.9f, 0.25f, 0.25f), 15.0f, block.Position, ResourceManager::GetTexture("powerup_chaos")));
+	for (unsigned int type = 0; type < POWERUP_TYPE_COUNT; ++type)
+		if (ShouldSpawn(this->Random.Gameplay, POWERUP_KINDS[type].SpawnChance))
+			this->PowerUps.Emplace(static_cast<PowerUpType>(type), position);
 }
 
-bool isOtherPowerUPActive(std::vector<PowerUP>& powerUps, std::string type)
+void Game::UpdatePowerUps(float dt)
 {
-	// Check if another PowerUp of the other type is still active
-	// in which case we don't disable its effect (yet)
-	for (const PowerUP& powerUp : powerUps)
-	{
-		if (powerUp.Activated && powerUp.Type == type)
-			return true;
-	}
-	return false;
+	for (PowerUP& powerUp : this->PowerUps)
+		powerUp.Position += VELOCITY * dt;
+	// Remove all PowerUps that are destroyed (either off the map or collected,
+	// collected effects keep running on their timer)
+	this->PowerUps.RemoveIf([](const PowerUP& powerUp) { return powerUp.Destroyed; });
 }
 
-void Game::UpdatePowerUps(float dt)
+void Game::UpdateTimers(float dt)
 {
-	for (PowerUP& powerUp : this->PowerUps)
+	this->Timers.Advance(dt, [this](const Timer& timer)
 	{
-		powerUp.Position += powerUp.Velocity * dt;
-		if (powerUp.Activated)
+		switch (timer.Event)
 		{
-			powerUp.Duration -= dt;
-			if (powerUp.Duration <= 0.0f)
-			{
-				// remove powerup from list (will later be removed)
-				powerUp.Activated = false;
-				// deactivate effects
-				if (powerUp.Type == "sticky" && !isOtherPowerUPActive(this->PowerUps, "sticky"))
-				{
-					Ball->Sticky = false;
-					Player->Colour = glm::vec3(1.0f);
-				}
-				else if (powerUp.Type == "pass_through" && !isOtherPowerUPActive(this->PowerUps, "pass_through"))
-				{
-					Ball->PassThrough = false;
-					Ball->Colour = glm::vec3(1.0f);
-				}
-				else if (powerUp.Type == "confuse" && !isOtherPowerUPActive(this->PowerUps, "confuse"))
-				{
-					Effects->Confuse = false;
-				}
-				else if (powerUp.Type == "chaos" && !isOtherPowerUPActive(this->PowerUps, "chaos"))
-				{
-					Effects->Chaos = false;
-				}
-			}
+		case TIMER_POWERUP_EXPIRED:
+			this->DeactivatePowerUp(static_cast<PowerUpType>(timer.Payload));
+			break;
+		case TIMER_SHAKE_ENDED:
+			// ignore timers that were replaced by a later hit
+			if (timer.Id == this->ShakeTimer)
+				this->Effects.Shake = false;
+			break;
 		}
-	}
-	// Remove all PowerUps from vector that are destroyed AND !activated (thus either off the map or finished)
-	// Use a lambda expression to remove each PowerUp which is destroyed and not activated
-	this->PowerUps.erase(std::remove_if(this->PowerUps.begin(), this->PowerUps.end(),
-		[](const PowerUP& powerUp) {return powerUp.Destroyed && !powerUp.Activated; }
-	), this->PowerUps.end());
-}
\ No newline at end of file
+	});
+}
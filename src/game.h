@@ -1,11 +1,25 @@
 #ifndef GAME_H
 #define GAME_H
 
-#include <GLAD/glad/glad.h>
+// only the key codes of GLFW are used, the simulation needs no GL context
+#define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <tuple>
+#include <vector>
 #include "ball_object.h"
 #include "game_level.h"
+#include "level_catalog.h"
 #include "power_up.h"
+#include "particle_generator.h"
+#include "audio_player.h"
+#include "game_random.h"
+#include "phase_timer.h"
+#include "timer_queue.h"
+#include "slot_pool.h"
+#include "ring_buffer.h"
 // current state of the game
 enum GameState
 {
@@ -26,6 +40,47 @@ enum Direction
 // defines a Collision typedef that represents collision data
 typedef std::tuple<bool, Direction, glm::vec2> Collision; //(collision?,direction, center - closet point)
 
+// single ball/brick contact gathered during a collision step
+struct Contact
+{
+	glm::vec2	Normal;			// axis aligned, points from the brick towards the ball
+	float		Penetration;	// depth of the ball inside the brick along the normal
+};
+
+// maximum number of brick contacts resolved per collision step
+const unsigned int MAX_CONTACTS = 8;
+
+// post-processing effects toggled by the game, applied by the renderer
+struct GameEffects
+{
+	bool Confuse, Chaos, Shake;
+};
+
+// things that happened during a collision pass
+enum GameEventType : uint8_t
+{
+	EVENT_BRICK_DESTROYED,
+	EVENT_SOLID_HIT,
+	EVENT_PADDLE_HIT,
+	EVENT_POWERUP_COLLECTED,
+	EVENT_TYPE_COUNT
+};
+
+// compact record of a collision, the side effects (sounds, power-ups,
+// shake, listeners) are applied afterwards by Game::DispatchEvents
+struct GameEvent
+{
+	GameEventType	Type;
+	uint8_t			PowerUp;	// PowerUpType of EVENT_POWERUP_COLLECTED
+	uint32_t		Cell;		// brick of EVENT_BRICK_DESTROYED and EVENT_SOLID_HIT
+};
+
+// capacity of the per-frame event queue (a full queue is dispatched early)
+const unsigned int MAX_EVENTS = 64;
+
+// called after a brick was destroyed, with the level and the cell of the brick
+typedef std::function<void(const GameLevel& level, unsigned int cell)> BrickDestroyedListener;
+
 // Initial size of the player paddle
 const glm::vec2 PLAYER_SIZE(200.0f, 50.0f);
 // Initial velocity of the player paddle
@@ -36,38 +91,147 @@ const float BALL_RADIUS = 40.0f;
 // Initial velocity of the Ball
 const glm::vec2 BALL_VELOCITY(0.0f, -950.0f);
 
+// Lives at the start of a game
+const unsigned int START_LIVES = 3;
+
+// Maximum number of PowerUps falling at the same time (further spawns are dropped)
+const unsigned int MAX_POWERUPS = 64;
+
+// Duration of the screen shake after hitting a solid block
+const float SHAKE_DURATION = 0.05f;
+
+// Rows of the endless level (seeded with the game's seed) and the speed they descend at
+const LevelRecipe ENDLESS_RECIPE = { 15, 8, 0.6f, 0.1f, 4, 0 };
+const float ENDLESS_SPEED = 10.0f;
+
+// Amount of particles trailing the Ball
+const unsigned int PARTICLE_AMOUNT = 2000;
+
+// flat copy of the simulation state of a Game: plain data without pointers or GL
+// handles, so it can be copied, kept or sent as bytes. In a snapshot it is followed
+// by TimerCount timers and the brick state of the current level (see LevelSnapshot).
+// Particles, sound, listeners and profiling are not part of it (the visual random
+// stream is, so particles carry on from where they are). Only the current level's
+// bricks are saved: the other levels are not checkpointed, a level is reset before
+// the menu can switch away from it, so they hold no damage while a game is played.
+struct GameSnapshot
+{
+	uint32_t				Size;	// bytes of the whole snapshot
+	uint32_t				Level;
+	GameState				State;
+	unsigned int			Lives;
+	bool					Keys[1024];
+	bool					KeysProcessed[1024];
+	GameObject				Player;
+	BallObject				Ball;
+	Appearance				PlayerAppearance, BallAppearance;
+	GameEffects				Effects;
+	SlotPool<PowerUP, MAX_POWERUPS> PowerUps;
+	RingBuffer<GameEvent, MAX_EVENTS> Events;
+	unsigned int			ActivePowerUps[POWERUP_TYPE_COUNT];
+	uint32_t				ShakeTimer;
+	RandomState				Random;
+	double					Now;
+	uint32_t				NextTimerId;
+	uint32_t				TimerCount;
+	LevelSnapshot			Bricks;
+};
+
+// Game holds the complete simulation state and the step functions of Breakout.
+// It has no dependency on GL or on a sound device: rendering is done by the
+// GameRenderer reading this state, sounds go through the AudioPlayer interface.
+// All state is owned by the instance, so any number of games can be stepped
+// concurrently (see BatchGame).
 class Game
 {
 public:
-	// levels
+	// levels (one per catalog entry, parsed once selected or prefetched, and the endless level last)
+	LevelCatalog			Catalog;
 	std::vector<GameLevel>	Levels;
-	std::vector<PowerUP>	PowerUps;
+	SlotPool<PowerUP, MAX_POWERUPS> PowerUps;
 	unsigned int			Level;
 	// game state
 	GameState				State;
 	bool					Keys[1024];
 	bool					KeysProcessed[1024];
-	unsigned int			Width, Height;
+	unsigned int			Width, Height;	// screen size, the playfield can be larger (see WorldSize)
 	unsigned int			Lives;
+	// game objects (hot simulation state)
+	GameObject				Player;
+	BallObject				Ball;
+	// render state of the game objects, only read by the renderer
+	Appearance				PlayerAppearance;
+	Appearance				BallAppearance;
+	ParticleGenerator		Particles;
+	GameEffects				Effects;
+	// timed effects (power-up durations, screen shake)
+	TimerQueue				Timers;
+	uint32_t				ShakeTimer;
+	// events of the current collision pass, dispatched after it
+	RingBuffer<GameEvent, MAX_EVENTS> Events;
+	// number of activated PowerUps per kind whose duration did not run out yet
+	unsigned int			ActivePowerUps[POWERUP_TYPE_COUNT];
+	// random streams (gameplay and visuals), seeded with Seed
+	GameRandom				Random;
+	// per-phase timing of the last Update, only measured while Profiling is set
+	bool					Profiling;
+	PhaseTimes				Phases;
+	// bytes of game state read by the last collision pass
+	unsigned int			CollisionBytes;
+	// sound output (not owned, defaults to a silent player)
+	AudioPlayer*			Audio;
+	// subscribers to brick destruction (copied along with the game)
+	std::vector<BrickDestroyedListener> BrickDestroyedListeners;
 	// constructor/destructor
 	Game(unsigned int width, unsigned int height);
 	~Game();
-	// initialize game state (load all shaders/textures/levels)
+	// initialize game state (scan the levels, load the first one)
 	void Init();
 	// game loop
 	void ProcessInput(float dt);
 	void Update(float dt);
-	void Render();
 	// check collisions
-	bool CheckCollision(GameObject& one, GameObject& two); // (axis-aligned box bounding algorithm)
-	Collision CheckCollision(BallObject& ball, GameObject& obj); // (algorithm between circle and rectangle)
+	bool CheckCollision(const GameObject& one, glm::vec2 position, glm::vec2 size); // (axis-aligned box bounding algorithm)
+	Collision CheckCollision(const BallObject& ball, glm::vec2 position, glm::vec2 size); // (algorithm between circle and rectangle)
 	void DoCollisions();
+	// applies the side effects of the queued events in batches
+	void DispatchEvents();
+	// subscribe to brick destruction
+	void OnBrickDestroyed(BrickDestroyedListener listener);
+	// seed the random streams of this game
+	void Seed(uint64_t seed);
+	// saves the simulation state as a snapshot (see GameSnapshot, the vector's memory is
+	// reused) and restores it; Restore fails if the snapshot does not fit the levels
+	void Save(std::vector<uint8_t>& snapshot) const;
+	bool Restore(const std::vector<uint8_t>& snapshot);
+	// playfield of the current level in world units (at least the screen) and the
+	// top-left corner of the part shown on screen (follows the ball)
+	glm::vec2 WorldSize() const;
+	glm::vec2 ViewPosition() const;
+	// levels
+	void SelectLevel(unsigned int index);
+	void PrefetchLevel(unsigned int index);
+	// re-parses the level stored at path after it was edited, keeps the current level index;
+	// false if nothing was reloaded (no such level, not parsed yet, or the file does not parse)
+	bool ReloadLevel(const std::string& path);
 	// reset
 	void ResetLevel();
 	void ResetPlayer();
 	// powerups
-	void SpawnPowerUps(GameObject& block);
+	void SpawnPowerUps(glm::vec2 position);
+	void ActivatePowerUp(PowerUpType type);
+	void DeactivatePowerUp(PowerUpType type);
 	void UpdatePowerUps(float dt);
+	// timers
+	void UpdateTimers(float dt);
+private:
+	// levels being parsed on a worker thread, and which of Levels hold a parsed level
+	std::vector<std::shared_future<GameLevel>> levelLoads;
+	std::vector<bool>		levelReady;
+	// parses a level unless it is ready (waiting for its prefetch), without selecting it
+	void loadLevel(unsigned int index);
+	// queues an event of the collision pass
+	void emit(GameEvent event);
 };
 
 #endif GAME_H
@@ -1,87 +1,430 @@
 #include "game_level.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
 #include <string>
-#include <sstream>
+
+// brick colour per tile code, codes past the end are drawn white
+const glm::vec3 PALETTE[] =
+{
+    glm::vec3(1.0f),                // empty
+    glm::vec3(0.8f, 0.8f, 0.7f),    // solid
+    glm::vec3(0.2f, 0.6f, 1.0f),
+    glm::vec3(0.0f, 0.7f, 0.0f),
+    glm::vec3(0.8f, 0.8f, 0.4f),
+    glm::vec3(1.0f, 0.5f, 0.0f)
+};
+const unsigned int PALETTE_SIZE = sizeof(PALETTE) / sizeof(PALETTE[0]);
 
 void GameLevel::Load(const char* file, unsigned int levelWidth, unsigned int levelHeight)
 {
-    // clear old data in array of bricks
-    this->Bricks.clear();
-    // load from file
-    GameLevel level;
-    // for reading a number
-    unsigned int tileCode;
-    std::string line;
-    std::ifstream fstream(file);
-    std::vector<std::vector<unsigned int>> tileData;
+    this->clear();
+    // map the file and parse it in place
+    MappedFile map;
+    if (!map.Open(file))
+        return;
+    if (!this->parseBinary(map.Data(), map.Size()) && !this->parseChunked(file, map.Data(), map.Size()))
+        this->parseText(map.Data(), map.Size());
+    if (this->Columns > 0 && this->Rows > 0)
+        this->init(levelWidth, levelHeight);
+    else
+    {
+        this->Tiles.clear();
+        this->Columns = this->Rows = 0;
+    }
+}
 
-    if (fstream)
+void GameLevel::Create(std::vector<uint8_t> tiles, unsigned int columns, unsigned int rows, unsigned int levelWidth, unsigned int levelHeight)
+{
+    this->clear();
+    if (columns == 0 || rows == 0 || tiles.size() != static_cast<size_t>(columns) * rows)
+        return;
+    this->Tiles = std::move(tiles);
+    this->Columns = columns;
+    this->Rows = rows;
+    this->init(levelWidth, levelHeight);
+}
+
+bool GameLevel::Save(const char* file) const
+{
+    LevelFileHeader header = { { 'L', 'V', 'L', 'B' }, LEVEL_FILE_VERSION, this->Columns, this->Rows };
+    std::ofstream fstream(file, std::ios::binary);
+    fstream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fstream.write(reinterpret_cast<const char*>(this->Tiles.data()), this->Tiles.size());
+    return static_cast<bool>(fstream);
+}
+
+bool GameLevel::SaveText(const char* file) const
+{
+    std::ofstream fstream(file, std::ios::binary);
+    std::string line;
+    for (unsigned int y = 0; y < this->Rows; ++y)
     {
-        while (std::getline(fstream, line)) // read each line from level file
+        line.clear();
+        for (unsigned int x = 0; x < this->Columns; ++x)
+        {
+            line += std::to_string(this->Tiles[static_cast<size_t>(y) * this->Columns + x]);
+            line += x + 1 < this->Columns ? ' ' : '\n';
+        }
+        fstream << line;
+    }
+    return static_cast<bool>(fstream);
+}
+
+bool GameLevel::SaveChunked(const char* file) const
+{
+    ChunkedLevelHeader header = { { 'L', 'V', 'L', 'C' }, CHUNKED_LEVEL_VERSION, this->Columns, this->Rows, this->pristineBricks };
+    std::ofstream fstream(file, std::ios::binary);
+    // the header is padded to a chunk so every chunk starts on a page of its own
+    std::vector<char> chunk(LEVEL_CHUNK_BYTES, 0);
+    std::memcpy(chunk.data(), &header, sizeof(header));
+    fstream.write(chunk.data(), chunk.size());
+    for (unsigned int chunkY = 0; chunkY < this->Rows; chunkY += LEVEL_CHUNK_SIZE)
+        for (unsigned int chunkX = 0; chunkX < this->Columns; chunkX += LEVEL_CHUNK_SIZE)
         {
-            std::istringstream sstream(line);
-            std::vector<unsigned int> row;
-            while (sstream >> tileCode) // read each number separated by space
-                row.push_back(tileCode);
-            tileData.push_back(row);
+            std::fill(chunk.begin(), chunk.end(), 0);
+            unsigned int width = std::min(LEVEL_CHUNK_SIZE, this->Columns - chunkX);
+            for (unsigned int y = 0; y < LEVEL_CHUNK_SIZE && chunkY + y < this->Rows; ++y)
+                std::memcpy(&chunk[y * LEVEL_CHUNK_SIZE], &this->Tiles[static_cast<size_t>(chunkY + y) * this->Columns + chunkX], width);
+            fstream.write(chunk.data(), chunk.size());
         }
-        if (tileData.size() > 0)
-            this->init(tileData, levelWidth, levelHeight);
+    return static_cast<bool>(fstream);
+}
+
+bool GameLevel::parseBinary(const char* data, size_t size)
+{
+    LevelFileHeader header;
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.Magic, "LVLB", 4) != 0)
+        return false;
+    size_t cells = static_cast<size_t>(header.Columns) * header.Rows;
+    if (header.Version != LEVEL_FILE_VERSION || size - sizeof(header) < cells)
+    {
+        std::cout << "ERROR::LEVEL: Unsupported or truncated binary level file" << std::endl;
+        return true;
+    }
+    this->Columns = header.Columns;
+    this->Rows = header.Rows;
+    this->Tiles.assign(data + sizeof(header), data + sizeof(header) + cells);
+    return true;
+}
+
+bool GameLevel::parseChunked(const char* file, const char* data, size_t size)
+{
+    if (size < 4 || std::memcmp(data, "LVLC", 4) != 0)
+        return false;
+    // the tile codes stay in the file, Stream pages them in while playing
+    if (this->Chunks.Open(file, this->pristineBricks))
+    {
+        this->Columns = this->Chunks.Columns;
+        this->Rows = this->Chunks.Rows;
     }
+    return true;
 }
 
-void GameLevel::Draw(SpriteRenderer& renderer)
+// parses the tile codes of a line starting at text, writes at most count codes to
+// tiles (nullptr only counts them) and returns the number of codes in the line
+unsigned int parseRow(const char* text, const char* lineEnd, uint8_t* tiles, unsigned int count)
 {
-    for (GameObject& tile : this->Bricks)
-        if (!tile.Destroyed)
-            tile.Draw(renderer);
+    unsigned int x = 0;
+    while (x < count)
+    {
+        // skip the separators (and the \r of windows line endings)
+        while (text < lineEnd && (*text == ' ' || *text == '\t' || *text == '\r'))
+            ++text;
+        unsigned int tileCode;
+        std::from_chars_result result = std::from_chars(text, lineEnd, tileCode);
+        // the row ends at the end of the line or at the first thing that is not a number
+        if (result.ptr == text)
+            break;
+        if (tiles)
+            tiles[x] = static_cast<uint8_t>(result.ec == std::errc() && tileCode < 255 ? tileCode : 255);
+        text = result.ptr;
+        ++x;
+    }
+    return x;
+}
+
+void GameLevel::parseText(const char* data, size_t size)
+{
+    if (size == 0)
+        return;
+    const char* end = data + size;
+    // every line is a row, the last one does not need a line break
+    this->Rows = static_cast<unsigned int>(std::count(data, end, '\n')) + (end[-1] != '\n');
+    // the first row defines the width, other rows are padded or cut to it
+    const char* lineEnd = static_cast<const char*>(std::memchr(data, '\n', size));
+    this->Columns = parseRow(data, lineEnd ? lineEnd : end, nullptr, UINT_MAX);
+    if (this->Columns == 0)
+        return;
+    // parse straight into the final grid
+    this->Tiles.assign(static_cast<size_t>(this->Columns) * this->Rows, 0);
+    const char* line = data;
+    for (unsigned int y = 0; y < this->Rows; ++y)
+    {
+        lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineEnd)
+            lineEnd = end;
+        parseRow(line, lineEnd, &this->Tiles[static_cast<size_t>(y) * this->Columns], this->Columns);
+        line = lineEnd + 1;
+    }
 }
 
-bool GameLevel::isCompleted()
+void GameLevel::Stream(glm::vec2 focusMin, glm::vec2 focusMax, glm::vec2 viewMin, glm::vec2 viewMax)
 {
-    for (GameObject& tile : this->Bricks)
-        if (!tile.IsSolid && !tile.Destroyed)
+    if (!this->Chunks.IsOpen())
+        return;
+    // chunks covered by the focus, and by the view plus a chunk around it so the
+    // camera finds its chunks paged in when it moves on (empty rectangles have min > max)
+    glm::uvec2 first, last;
+    glm::ivec2 requiredMin(1), requiredMax(0), wantedMin(1), wantedMax(0);
+    if (this->cellRange(focusMin, focusMax, first, last))
+    {
+        requiredMin = glm::ivec2(first / LEVEL_CHUNK_SIZE);
+        requiredMax = glm::ivec2(last / LEVEL_CHUNK_SIZE);
+    }
+    if (this->cellRange(viewMin, viewMax, first, last))
+    {
+        glm::ivec2 chunks(this->Chunks.ChunksX, this->Chunks.ChunksY);
+        wantedMin = glm::max(glm::ivec2(first / LEVEL_CHUNK_SIZE) - 1, glm::ivec2(0));
+        wantedMax = glm::min(glm::ivec2(last / LEVEL_CHUNK_SIZE) + 1, chunks - 1);
+    }
+    this->Chunks.Stream(requiredMin, requiredMax, wantedMin, wantedMax);
+}
+
+size_t GameLevel::StateSize() const
+{
+    return this->Live.size() * sizeof(uint64_t) + (this->Endless ? this->Tiles.size() : 0)
+        + this->Chunks.DeltaCount() * CHUNK_DELTA_BYTES;
+}
+
+LevelSnapshot GameLevel::SaveState(uint8_t* data) const
+{
+    LevelSnapshot state = {};
+    state.LiveBricks = this->LiveBricks;
+    state.TopRow = this->TopRow;
+    state.Top = this->Top;
+    std::memcpy(state.RowRandom, this->rowRandom.State, sizeof(state.RowRandom));
+    state.Words = static_cast<uint32_t>(this->Live.size());
+    state.TileBytes = this->Endless ? static_cast<uint32_t>(this->Tiles.size()) : 0;
+    state.Deltas = this->Chunks.DeltaCount();
+    // chunked levels keep no live bits and only endless levels keep their tiles here,
+    // empty vectors are skipped (memcpy must not be handed their null pointer)
+    if (state.Words > 0)
+        std::memcpy(data, this->Live.data(), state.Words * sizeof(uint64_t));
+    data += state.Words * sizeof(uint64_t);
+    std::copy(this->Tiles.begin(), this->Tiles.begin() + state.TileBytes, data);
+    this->Chunks.SaveDeltas(data + state.TileBytes);
+    return state;
+}
+
+bool GameLevel::FitsState(const LevelSnapshot& state, const uint8_t* data, size_t size) const
+{
+    // the layout has to match this level exactly, only its brick state changes while playing
+    size_t cells = static_cast<size_t>(this->Columns) * this->Rows;
+    if (state.Words != this->Live.size() || state.TileBytes != (this->Endless ? this->Tiles.size() : 0)
+        || (state.Deltas > 0 && !this->Chunks.IsOpen()) || (state.TopRow > 0 && state.TopRow >= this->Rows)
+        || state.LiveBricks > cells || !std::isfinite(state.Top)
+        || size != state.Words * sizeof(uint64_t) + state.TileBytes + static_cast<size_t>(state.Deltas) * CHUNK_DELTA_BYTES)
+        return false;
+    // no live bits past the last cell
+    if (state.Words > 0 && cells % 64 != 0)
+    {
+        uint64_t last;
+        std::memcpy(&last, data + (state.Words - 1) * sizeof(uint64_t), sizeof(last));
+        if (last >> (cells % 64) != 0)
             return false;
+    }
+    // deltas of chunks of the level
+    const uint8_t* deltas = data + state.Words * sizeof(uint64_t) + state.TileBytes;
+    for (unsigned int i = 0; i < state.Deltas; ++i)
+    {
+        uint32_t chunk;
+        std::memcpy(&chunk, deltas + i * CHUNK_DELTA_BYTES, sizeof(chunk));
+        if (chunk >= this->Chunks.ChunksX * this->Chunks.ChunksY)
+            return false;
+    }
     return true;
 }
 
-void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight)
+bool GameLevel::RestoreState(const LevelSnapshot& state, const uint8_t* data, size_t size)
 {
-    // calculate dimensions
-    unsigned int height = static_cast<unsigned int>(tileData.size());
-    unsigned int width = static_cast<unsigned int>(tileData[0].size());
-    float unit_width = levelWidth / static_cast<float>(width);
-    float unit_height = levelHeight / static_cast<float>(height);
-    // initialize level tiles based on tileData
-    for (unsigned int y = 0; y < height; ++y)
+    if (!this->FitsState(state, data, size))
+        return false;
+    this->LiveBricks = state.LiveBricks;
+    this->TopRow = state.TopRow;
+    this->Top = state.Top;
+    std::memcpy(this->rowRandom.State, state.RowRandom, sizeof(state.RowRandom));
+    if (state.Words > 0)
+        std::memcpy(this->Live.data(), data, state.Words * sizeof(uint64_t));
+    data += state.Words * sizeof(uint64_t);
+    std::copy(data, data + state.TileBytes, this->Tiles.begin());
+    if (this->Chunks.IsOpen())
+        this->Chunks.RestoreDeltas(data + state.TileBytes, state.Deltas);
+    return true;
+}
+
+void GameLevel::Reset()
+{
+    if (this->Chunks.IsOpen())
+        this->Chunks.Reset();
+    // endless levels start over from their first rows (the refilled rows overwrote the grid)
+    if (this->Endless)
     {
-        for (unsigned int x = 0; x < width; ++x)
+        this->restartEndless();
+        return;
+    }
+    std::copy(this->pristineLive.begin(), this->pristineLive.end(), this->Live.begin());
+    this->LiveBricks = this->pristineBricks;
+}
+
+bool GameLevel::isCompleted() const
+{
+    // the counter is kept up to date by init and Destroy, debug builds verify it
+    assert(this->LiveBricks == this->countBricks());
+    return this->LiveBricks == 0 && !this->Endless;
+}
+
+void GameLevel::Destroy(unsigned int cell)
+{
+    assert(this->IsLive(cell) && !this->IsSolid(cell));
+    if (this->Chunks.IsOpen())
+        this->Chunks.Destroy(cell);
+    else
+        this->Live[cell / 64] &= ~(uint64_t(1) << (cell % 64));
+    --this->LiveBricks;
+}
+
+glm::vec3 GameLevel::BrickColour(unsigned int cell) const
+{
+    uint8_t code = this->Tile(cell);
+    return code < PALETTE_SIZE ? PALETTE[code] : glm::vec3(1.0f);
+}
+
+void GameLevel::clear()
+{
+    this->Tiles.clear();
+    this->Live.clear();
+    this->pristineLive.clear();
+    this->Chunks.Close();
+    this->Columns = this->Rows = 0;
+    this->LiveBricks = this->pristineBricks = 0;
+    this->Endless = false;
+    this->TopRow = 0;
+    this->Top = 0.0f;
+}
+
+void GameLevel::CreateEndless(const LevelRecipe& recipe, unsigned int levelWidth, unsigned int levelHeight)
+{
+    this->clear();
+    if (recipe.Columns == 0 || recipe.Rows == 0)
+        return;
+    this->Endless = true;
+    this->Recipe = recipe;
+    this->Columns = recipe.Columns;
+    this->Rows = recipe.Rows;
+    this->Tiles.assign(static_cast<size_t>(this->Columns) * this->Rows, 0);
+    this->init(levelWidth, levelHeight);
+    this->restartEndless();
+}
+
+void GameLevel::Descend(float distance)
+{
+    if (!this->Endless)
+        return;
+    this->Top += distance;
+    // once the top row is fully in, the bottom row has left: it is refilled as the new top row
+    while (this->Top >= 0.0f)
+    {
+        this->Top -= this->BrickSize.y;
+        this->TopRow = this->TopRow > 0 ? this->TopRow - 1 : this->Rows - 1;
+        unsigned int begin = this->TopRow * this->Columns;
+        // the bricks the row still held are gone
+        for (unsigned int cell = begin; cell < begin + this->Columns; ++cell)
+            if (this->IsLive(cell) && !this->IsSolid(cell))
+                --this->LiveBricks;
+        GenerateRow(this->Recipe, this->rowRandom, &this->Tiles[begin]);
+        for (unsigned int cell = begin; cell < begin + this->Columns; ++cell)
+        {
+            uint64_t bit = uint64_t(1) << (cell % 64);
+            if (this->Tiles[cell] != 0)
+                this->Live[cell / 64] |= bit;
+            else
+                this->Live[cell / 64] &= ~bit;
+            this->LiveBricks += this->Tiles[cell] > TILE_SOLID;
+        }
+    }
+}
+
+void GameLevel::restartEndless()
+{
+    this->rowRandom.Seed(this->Recipe.Seed);
+    for (unsigned int y = 0; y < this->Rows; ++y)
+        GenerateRow(this->Recipe, this->rowRandom, &this->Tiles[static_cast<size_t>(y) * this->Columns]);
+    this->initBricks();
+    // the first row waits above the grid area
+    this->TopRow = 0;
+    this->Top = -this->BrickSize.y;
+}
+
+void GameLevel::init(unsigned int levelWidth, unsigned int levelHeight)
+{
+    // calculate dimensions (bricks fill the given area unless that makes them smaller than MIN_BRICK_SIZE)
+    float unit_width = levelWidth / static_cast<float>(this->Columns);
+    float unit_height = levelHeight / static_cast<float>(this->Rows);
+    this->BrickSize = glm::max(glm::vec2(unit_width, unit_height), MIN_BRICK_SIZE);
+    // chunked levels build the bitmap of a chunk when it is paged in
+    if (this->Chunks.IsOpen())
+    {
+        this->LiveBricks = this->pristineBricks;
+        return;
+    }
+    this->initBricks();
+}
+
+void GameLevel::initBricks()
+{
+    // every non-empty cell starts with a brick
+    unsigned int cells = static_cast<unsigned int>(this->Tiles.size());
+    // (built a word at a time without branches, so huge levels initialize quickly)
+    this->Live.assign((cells + 63) / 64, 0);
+    const uint8_t* tiles = this->Tiles.data();
+    unsigned int bricks = 0;
+    for (unsigned int word = 0; word < this->Live.size(); ++word)
+    {
+        unsigned int begin = word * 64;
+        unsigned int count = std::min(64u, cells - begin);
+        uint64_t bits = 0;
+        for (unsigned int i = 0; i < count; ++i)
         {
-            // check block type from level data (2D level array)
-            if (tileData[y][x] == 1)
-            {
-                glm::vec2 pos(unit_width * x, unit_height * y);
-                glm::vec2 size(unit_width, unit_height);
-                GameObject obj(pos, size, ResourceManager::GetTexture("block_solid"), glm::vec3(0.8f, 0.8f, 0.7f));
-                obj.IsSolid = true;
-                this->Bricks.push_back(obj);
-            }
-            else if (tileData[y][x] > 1)
-            {
-                glm::vec3 colour = glm::vec3(1.0f);
-                if (tileData[y][x] == 2)
-                    colour = glm::vec3(0.2f, 0.6f, 1.0f);
-                else if (tileData[y][x] == 3)
-                    colour = glm::vec3(0.0f, 0.7f, 0.0f);
-                else if (tileData[y][x] == 4)
-                    colour = glm::vec3(0.8f, 0.8f, 0.4f);
-                else if (tileData[y][x] == 5)
-                    colour = glm::vec3(1.0f, 0.5f, 0.0f);
-
-                glm::vec2 pos(unit_width * x, unit_height * y);
-                glm::vec2 size(unit_width, unit_height);
-                GameObject obj(pos, size, ResourceManager::GetTexture("block"), colour);
-                this->Bricks.push_back(obj);
-            }
+            bits |= uint64_t(tiles[begin + i] != 0) << i;
+            bricks += tiles[begin + i] > TILE_SOLID;
         }
+        this->Live[word] = bits;
     }
+    this->LiveBricks = bricks;
+    // keep the loaded state for Reset
+    this->pristineLive = this->Live;
+    this->pristineBricks = bricks;
+}
+
+unsigned int GameLevel::countBricks() const
+{
+    if (this->Chunks.IsOpen())
+        return this->pristineBricks - this->Chunks.Destroyed();
+    unsigned int count = 0;
+    this->ForEachLive([&](unsigned int cell)
+    {
+        if (!this->IsSolid(cell))
+            ++count;
+    });
+    return count;
 }
@@ -1,31 +1,230 @@
 #ifndef GAMELEVEL_H
 #define GAMELEVEL_H
 
+#include <bit>
+#include <cstdint>
 #include <vector>
 
-#include <GLAD/glad/glad.h>
 #include <glm/glm.hpp>
 
-#include "resource_manager.h"
-#include "sprite_renderer.h"
-#include "game_object.h"
+#include "level_chunks.h"
+#include "level_generator.h"
+
+// header of a binary level file (.lvlb), followed by Columns * Rows tile
+// codes (one byte each, row major); fields are stored little endian
+struct LevelFileHeader
+{
+	char		Magic[4];	// "LVLB"
+	uint32_t	Version;
+	uint32_t	Columns, Rows;
+};
+const uint32_t LEVEL_FILE_VERSION = 1;
+
+// smallest size of a brick in world units, levels with more tiles than fit
+// the given area at this size extend beyond it (and are scrolled through)
+const glm::vec2 MIN_BRICK_SIZE(80.0f, 40.0f);
+
+// tile code of a solid (indestructible) brick, codes above are destructible, 0 is empty
+const uint8_t TILE_SOLID = 1;
+
+// brick state of a level in a game snapshot (see GameSnapshot); the snapshot holds Words
+// bitmap words after it, then TileBytes tile codes (the refilled grid of endless levels)
+// and Deltas chunk deltas (chunked levels, CHUNK_DELTA_BYTES each)
+struct LevelSnapshot
+{
+	uint32_t	LiveBricks;
+	uint32_t	TopRow;
+	float		Top;
+	uint32_t	RowRandom[4];
+	uint32_t	Words, TileBytes, Deltas;
+};
 
 // GameLevel holds all Tiles as part of a Breakout level and
-// hosts functionality to Load/render levels from the harddisk.
+// hosts functionality to Load levels from the harddisk, either as
+// text (.lvl, a line of tile codes per row) or binary (.lvlb).
+// A level is an implicit grid: one tile code byte per cell plus a
+// bitmap with a bit per cell that is set while the cell holds a brick.
+// Position and size of a brick follow from its cell, its colour from
+// the palette entry of its tile code, so a brick costs 9 bits.
+// Chunked levels (.lvlc) keep Tiles and Live empty, their cells are
+// paged in around the ball and the camera by Chunks (see Stream).
+// Endless levels are generated: the grid is a ring of rows that descends,
+// the row leaving at the bottom is refilled in place and enters at the top
+// (see Descend), so they never grow however long they are played.
 class GameLevel
 {
 public:
-	// level state
-	std::vector<GameObject> Bricks;
-	// loads level from file
+	// grid dimensions in cells
+	unsigned int			Columns, Rows;
+	// size of a single cell (and brick) in world units
+	glm::vec2				BrickSize;
+	// tile code per cell, row major
+	std::vector<uint8_t>	Tiles;
+	// a bit per cell, set while the cell holds a brick
+	std::vector<uint64_t>	Live;
+	// number of destructible bricks left
+	unsigned int			LiveBricks;
+	// pager of a chunked level (closed for other levels)
+	LevelChunks				Chunks;
+	// endless levels: the rows are generated from Recipe, TopRow is the row of the grid
+	// shown at the top and Top its world y (0 for other levels, the rows descend from above)
+	bool					Endless;
+	LevelRecipe				Recipe;
+	unsigned int			TopRow;
+	float					Top;
+	// constructor
+	GameLevel() : Columns(0), Rows(0), BrickSize(0.0f), LiveBricks(0), Endless(false), Recipe(), TopRow(0), Top(0.0f), pristineBricks(0) { }
+	// loads level from file (text or binary, told apart by the header)
 	void Load(const char* file, unsigned int levelWidth, unsigned int levelHeight);
-	// render level
-	void Draw(SpriteRenderer& renderer);
-	// check if the level is completed (all non-solid tiles are destroyed)
-	bool isCompleted();
+	// builds the level from a tile grid in memory (row major, columns * rows codes)
+	void Create(std::vector<uint8_t> tiles, unsigned int columns, unsigned int rows, unsigned int levelWidth, unsigned int levelHeight);
+	// bytes of brick state following the LevelSnapshot, writes it to data and reads it
+	// back (fails if it does not belong to this level: other size or kind of level)
+	size_t StateSize() const;
+	LevelSnapshot SaveState(uint8_t* data) const;
+	// true if a snapshot's brick state belongs to this level and is in range (no bricks
+	// past the grid or chunks outside it), checked without changing the level
+	bool FitsState(const LevelSnapshot& state, const uint8_t* data, size_t size) const;
+	bool RestoreState(const LevelSnapshot& state, const uint8_t* data, size_t size);
+	// builds an endless level whose rows are drawn from recipe
+	void CreateEndless(const LevelRecipe& recipe, unsigned int levelWidth, unsigned int levelHeight);
+	// moves the rows of an endless level down, refilling the ones that leave the grid
+	// as new top rows (does nothing for other levels)
+	void Descend(float distance);
+	// saves the tile grid as a binary, text or chunked level file
+	bool Save(const char* file) const;
+	bool SaveText(const char* file) const;
+	bool SaveChunked(const char* file) const;
+	// pages the chunks of a chunked level around the focus (the ball) in right away
+	// and the ones around the view in the background, does nothing for other levels
+	void Stream(glm::vec2 focusMin, glm::vec2 focusMax, glm::vec2 viewMin, glm::vec2 viewMax);
+	// restores every brick as loaded (a copy of the loaded bitmap, no file I/O or allocation)
+	void Reset();
+	// check if the level is completed (all non-solid tiles are destroyed, never for endless levels), O(1)
+	bool isCompleted() const;
+	// brick state of a cell
+	uint8_t Tile(unsigned int cell) const { return this->Chunks.IsOpen() ? this->Chunks.Tile(cell) : this->Tiles[cell]; }
+	bool IsLive(unsigned int cell) const
+	{
+		return this->Chunks.IsOpen() ? this->Chunks.IsLive(cell) : (this->Live[cell / 64] >> (cell % 64) & 1);
+	}
+	bool IsSolid(unsigned int cell) const { return this->Tile(cell) == TILE_SOLID; }
+	// destroys the (destructible) brick in a cell
+	void Destroy(unsigned int cell);
+	// derived brick state
+	glm::vec2 BrickPosition(unsigned int cell) const
+	{
+		// rows are shown from TopRow on, wrapping around the end of the grid
+		unsigned int row = cell / this->Columns;
+		row = row >= this->TopRow ? row - this->TopRow : row + this->Rows - this->TopRow;
+		return glm::vec2(this->BrickSize.x * (cell % this->Columns), this->Top + this->BrickSize.y * row);
+	}
+	glm::vec3 BrickColour(unsigned int cell) const;
+	// size of the whole grid in world units
+	glm::vec2 Size() const { return this->BrickSize * glm::vec2(this->Columns, this->Rows); }
+	// calls visit(cell) for every cell holding a brick in row major order,
+	// empty words of the bitmap are skipped 64 cells at a time (not for chunked levels)
+	template <typename F>
+	void ForEachLive(F visit) const
+	{
+		for (unsigned int word = 0; word < this->Live.size(); ++word)
+			for (uint64_t bits = this->Live[word]; bits != 0; bits &= bits - 1)
+				visit(word * 64 + std::countr_zero(bits));
+	}
+	// calls visit(cell) in row major order for every brick overlapping the rectangle [min, max]
+	// (edges included), only the bitmap words of the covered rows are read; returns their number
+	// (bricks of chunks that are not paged in are skipped)
+	template <typename F>
+	unsigned int ForEachLiveIn(glm::vec2 min, glm::vec2 max, F visit) const
+	{
+		glm::uvec2 first, last;
+		if (!this->cellRange(min, max, first, last))
+			return 0;
+		if (this->Chunks.IsOpen())
+			return this->forEachLiveInChunks(first, last, visit);
+		unsigned int words = 0;
+		for (unsigned int y = first.y; y <= last.y; ++y)
+		{
+			unsigned int row = y + this->TopRow < this->Rows ? y + this->TopRow : y + this->TopRow - this->Rows;
+			unsigned int begin = row * this->Columns + first.x;
+			unsigned int end = row * this->Columns + last.x;
+			for (unsigned int word = begin / 64; word <= end / 64; ++word, ++words)
+			{
+				uint64_t bits = this->Live[word];
+				// mask off the cells left of begin and right of end
+				if (word == begin / 64)
+					bits &= ~uint64_t(0) << (begin % 64);
+				if (word == end / 64)
+					bits &= ~uint64_t(0) >> (63 - end % 64);
+				for (; bits != 0; bits &= bits - 1)
+					visit(word * 64 + std::countr_zero(bits));
+			}
+		}
+		return words;
+	}
 private:
-	// initialize level from tile data
-	void init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight);
+	// bitmap and brick count right after loading (the tile codes never change)
+	std::vector<uint64_t>	pristineLive;
+	unsigned int			pristineBricks;
+	// read the tile grid from the mapped file contents
+	bool parseBinary(const char* data, size_t size);
+	void parseText(const char* data, size_t size);
+	// stream of the rows of an endless level
+	RandomStream			rowRandom;
+	// drops the current level
+	void clear();
+	// initialize level from the tile grid
+	void init(unsigned int levelWidth, unsigned int levelHeight);
+	// builds the bitmap and brick count from the tile grid and keeps them for Reset
+	void initBricks();
+	// fills the grid of an endless level with its first rows
+	void restartEndless();
+	bool parseChunked(const char* file, const char* data, size_t size);
+	// counts the destructible bricks left by scanning all cells (LiveBricks cross-check)
+	unsigned int countBricks() const;
+	// range of cells overlapping the rectangle [min, max], clamped to the grid; false if there are none
+	// (rows are counted from the top row shown, see TopRow)
+	bool cellRange(glm::vec2 min, glm::vec2 max, glm::uvec2& first, glm::uvec2& last) const
+	{
+		if (this->Columns == 0)
+			return false;
+		glm::vec2 origin(0.0f, this->Top);
+		glm::vec2 low = glm::floor((min - origin) / this->BrickSize);
+		glm::vec2 high = glm::floor((max - origin) / this->BrickSize);
+		glm::vec2 grid(this->Columns, this->Rows);
+		if (high.x < 0.0f || high.y < 0.0f || low.x >= grid.x || low.y >= grid.y)
+			return false;
+		first = glm::uvec2(glm::max(low, glm::vec2(0.0f)));
+		last = glm::uvec2(glm::min(high, grid - 1.0f));
+		return true;
+	}
+	// ForEachLiveIn of a chunked level, a bitmap word per row and paged in chunk
+	template <typename F>
+	unsigned int forEachLiveInChunks(glm::uvec2 first, glm::uvec2 last, F visit) const
+	{
+		unsigned int words = 0;
+		for (unsigned int y = first.y; y <= last.y; ++y)
+		{
+			unsigned int chunkRow = y / LEVEL_CHUNK_SIZE * this->Chunks.ChunksX;
+			for (unsigned int chunkX = first.x / LEVEL_CHUNK_SIZE; chunkX <= last.x / LEVEL_CHUNK_SIZE; ++chunkX)
+			{
+				const ChunkBits* bits = this->Chunks.Find(chunkRow + chunkX);
+				if (!bits)
+					continue;
+				++words;
+				uint64_t word = (*bits)[y % LEVEL_CHUNK_SIZE];
+				// mask off the cells left of first and right of last
+				unsigned int left = chunkX * LEVEL_CHUNK_SIZE;
+				if (first.x > left)
+					word &= ~uint64_t(0) << (first.x - left);
+				if (last.x < left + LEVEL_CHUNK_SIZE - 1)
+					word &= ~uint64_t(0) >> (left + LEVEL_CHUNK_SIZE - 1 - last.x);
+				for (; word != 0; word &= word - 1)
+					visit(y * this->Columns + left + std::countr_zero(word));
+			}
+		}
+		return words;
+	}
 };
 
 #endif
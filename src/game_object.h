@@ -1,34 +1,33 @@
 #ifndef GAMEOBJECT_H
 #define GAMEOBJECT_H
 
-#include <GLAD/glad/glad.h>
 #include <glm/glm.hpp>
 
-#include "texture.h"
-#include "sprite_renderer.h"
-
 
 // Container object for holding all state relevant for a single
 // game object entity. Each object in the game likely needs the
 // minimal of state as described within GameObject.
+// Only the hot state read by movement and collisions lives here,
+// everything that is only needed for drawing is kept apart in an
+// Appearance, so a collision pass never pulls render data into cache.
 
 class GameObject
 {
 public:
 	// object state
 	glm::vec2	Position, Size, Velocity;
-	glm::vec3	Colour;
-	float		Rotation;
 	bool		IsSolid;
 	bool		Destroyed;
-	// render state
-	Texture2D	Sprite;
 	// constructor(s)
 	GameObject();
-	GameObject(glm::vec2 pos, glm::vec2 size, Texture2D sprite, glm::vec3 colour = glm::vec3(1.0f),
-		glm::vec2 velocity = glm::vec2(0.0f, 0.0f));
-	// draw sprite
-	virtual void Draw(SpriteRenderer& renderer);
+	GameObject(glm::vec2 pos, glm::vec2 size, glm::vec2 velocity = glm::vec2(0.0f, 0.0f));
+};
+
+// cold render state of an object, only read by the GameRenderer
+struct Appearance
+{
+	glm::vec3	Colour;
+	float		Rotation;
 };
 
 #endif
\ No newline at end of file
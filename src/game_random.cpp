@@ -0,0 +1,93 @@
+#include "game_random.h"
+
+#include <cstring>
+
+// splitmix64, used to expand a seed into generator state
+uint64_t SplitMix64(uint64_t& x)
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+uint32_t RotateLeft(uint32_t x, int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+RandomStream::RandomStream(uint64_t seed)
+{
+	this->Seed(seed);
+}
+
+void RandomStream::Seed(uint64_t seed)
+{
+	uint64_t a = SplitMix64(seed);
+	uint64_t b = SplitMix64(seed);
+	this->State[0] = static_cast<uint32_t>(a);
+	this->State[1] = static_cast<uint32_t>(a >> 32);
+	this->State[2] = static_cast<uint32_t>(b);
+	this->State[3] = static_cast<uint32_t>(b >> 32);
+}
+
+uint32_t RandomStream::Next()
+{
+	uint32_t* s = this->State;
+	uint32_t result = RotateLeft(s[1] * 5, 7) * 9;
+	uint32_t t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = RotateLeft(s[3], 11);
+	return result;
+}
+
+uint32_t RandomStream::Below(uint32_t bound)
+{
+	// multiply-shift range reduction (Lemire), no modulo
+	return static_cast<uint32_t>((static_cast<uint64_t>(this->Next()) * bound) >> 32);
+}
+
+float RandomStream::Float()
+{
+	// upper 24 bits fill the float mantissa
+	return (this->Next() >> 8) * (1.0f / 16777216.0f);
+}
+
+GameRandom::GameRandom(uint64_t seed)
+{
+	this->Seed(seed);
+}
+
+void GameRandom::Seed(uint64_t seed)
+{
+	this->seed = seed;
+	// every stream gets its own, decorrelated seed
+	uint64_t x = seed;
+	this->Gameplay.Seed(SplitMix64(x));
+	this->Visual.Seed(SplitMix64(x));
+}
+
+uint64_t GameRandom::GetSeed() const
+{
+	return this->seed;
+}
+
+RandomState GameRandom::Save() const
+{
+	RandomState state;
+	state.Seed = this->seed;
+	std::memcpy(state.Gameplay, this->Gameplay.State, sizeof(state.Gameplay));
+	std::memcpy(state.Visual, this->Visual.State, sizeof(state.Visual));
+	return state;
+}
+
+void GameRandom::Restore(const RandomState& state)
+{
+	this->seed = state.Seed;
+	std::memcpy(this->Gameplay.State, state.Gameplay, sizeof(state.Gameplay));
+	std::memcpy(this->Visual.State, state.Visual, sizeof(state.Visual));
+}
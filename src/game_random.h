@@ -0,0 +1,56 @@
+#ifndef GAME_RANDOM_H
+#define GAME_RANDOM_H
+
+#include <cstdint>
+
+// RandomStream is a xoshiro128** pseudo random generator: 16 bytes of
+// state, no locks and no hidden globals. The state is a plain array so
+// it can be saved and restored together with the rest of the game.
+class RandomStream
+{
+public:
+	// generator state
+	uint32_t State[4];
+	// constructor (seeds the stream)
+	RandomStream(uint64_t seed = 0);
+	// re-seeds the stream (the seed is expanded with splitmix64)
+	void Seed(uint64_t seed);
+	// next raw 32 bit value
+	uint32_t Next();
+	// uniform value in [0, bound)
+	uint32_t Below(uint32_t bound);
+	// uniform value in [0, 1)
+	float Float();
+};
+
+// serializable state of a GameRandom
+struct RandomState
+{
+	uint64_t Seed;
+	uint32_t Gameplay[4];
+	uint32_t Visual[4];
+};
+
+// GameRandom is the random service of a single game. Gameplay decisions
+// (power-up spawns) and cosmetics (particles) draw from separate streams,
+// so visual settings can never change the outcome of a run.
+class GameRandom
+{
+public:
+	// streams
+	RandomStream Gameplay;
+	RandomStream Visual;
+	// constructor
+	GameRandom(uint64_t seed = 0);
+	// seeds both streams from a single seed
+	void Seed(uint64_t seed);
+	// the seed the streams were last seeded with
+	uint64_t GetSeed() const;
+	// save/restore the complete random state
+	RandomState Save() const;
+	void Restore(const RandomState& state);
+private:
+	uint64_t seed;
+};
+
+#endif
\ No newline at end of file
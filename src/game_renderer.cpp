@@ -0,0 +1,111 @@
+#include "game_renderer.h"
+#include "resource_manager.h"
+#include <sstream>
+
+GameRenderer::GameRenderer(unsigned int width, unsigned int height)
+	: width(width), height(height), sprites(nullptr), particles(nullptr), effects(nullptr), text(nullptr), powerUpTextures()
+{
+}
+
+GameRenderer::~GameRenderer()
+{
+	delete this->sprites;
+	delete this->particles;
+	delete this->effects;
+	delete this->text;
+}
+
+void GameRenderer::Init()
+{
+	// load shaders
+	ResourceManager::LoadShader("shaders/sprite.vert", "shaders/sprite.frag",nullptr,"sprite");
+	ResourceManager::LoadShader("shaders/particle.vert", "shaders/particle.frag",nullptr,"particle");
+	ResourceManager::LoadShader("shaders/post_processing.vert", "shaders/post_processing.frag",nullptr,"postprocessing");
+	// configure shaders (the view-projection follows the camera, it is set every frame)
+	ResourceManager::GetShader("sprite").Use();
+	ResourceManager::GetShader("sprite").setInt("image", 0);
+	ResourceManager::GetShader("particle").Use();
+	ResourceManager::GetShader("particle").setInt("sprite", 0);
+	// load textures
+	ResourceManager::LoadTexture("textures/awesomeface.png", true, "face");
+	ResourceManager::LoadTexture("textures/block.png", false, "block");
+	ResourceManager::LoadTexture("textures/block_solid.png", false, "block_solid");
+	ResourceManager::LoadTexture("textures/background.jpg", false, "background");
+	ResourceManager::LoadTexture("textures/paddle.png", true, "player");
+	ResourceManager::LoadTexture("textures/particle.png", true, "particle");
+	ResourceManager::LoadTexture("textures/powerup_speed.png", true, "powerup_speed");
+	ResourceManager::LoadTexture("textures/powerup_confuse.png", true, "powerup_confuse");
+	ResourceManager::LoadTexture("textures/powerup_chaos.png", true, "powerup_chaos");
+	ResourceManager::LoadTexture("textures/powerup_increase.png", true, "powerup_increase");
+	ResourceManager::LoadTexture("textures/powerup_passthrough.png", true, "powerup_passthrough");
+	ResourceManager::LoadTexture("textures/powerup_sticky.png", true, "powerup_sticky");
+	// set render specific controls
+	this->sprites = new SpriteRenderer(ResourceManager::GetShader("sprite"));
+	this->particles = new ParticleRenderer(ResourceManager::GetShader("particle"), ResourceManager::GetTexture("particle"));
+	this->effects = new PostProcessor(ResourceManager::GetShader("postprocessing"), this->width, this->height);
+	this->text = new TextRenderer(this->width, this->height);
+	this->text->Load("resources/fonts/times.ttf",90);
+	// resolve the PowerUp textures once, PowerUps are drawn every frame
+	for (unsigned int type = 0; type < POWERUP_TYPE_COUNT; ++type)
+		this->powerUpTextures[type] = &ResourceManager::GetTexture(POWERUP_KINDS[type].Texture);
+}
+
+void GameRenderer::Render(const Game& game, float time)
+{
+	if (game.State == GAME_ACTIVE || game.State == GAME_MENU || game.State == GAME_WIN)
+	{
+		// view-projection of the camera, the playfield can be larger than the screen
+		glm::vec2 screen(this->width, this->height);
+		glm::vec2 view = game.ViewPosition();
+		glm::mat4 viewProjection = glm::ortho(view.x, view.x + screen.x, view.y + screen.y, view.y, -1.0f, 1.0f);
+		ResourceManager::GetShader("sprite").setMat4("projection", viewProjection, true);
+		ResourceManager::GetShader("particle").setMat4("projection", viewProjection, true);
+		// begin rendering to postprocessing framebuffer
+		this->effects->BeginRender();
+		// draw background (fixed to the screen)
+		this->sprites->DrawSprite(ResourceManager::GetTexture("background"), view, screen);
+		// draw the bricks in view
+		Texture2D& block = ResourceManager::GetTexture("block");
+		Texture2D& blockSolid = ResourceManager::GetTexture("block_solid");
+		const GameLevel& level = game.Levels[game.Level];
+		level.ForEachLiveIn(view, view + screen, [&](unsigned int cell)
+		{
+			this->sprites->DrawSprite(level.IsSolid(cell) ? blockSolid : block, level.BrickPosition(cell),
+				level.BrickSize, 0.0f, level.BrickColour(cell));
+		});
+		// draw player
+		const GameObject& player = game.Player;
+		this->sprites->DrawSprite(ResourceManager::GetTexture("player"), player.Position, player.Size, game.PlayerAppearance.Rotation, game.PlayerAppearance.Colour);
+		// draw powerUps (size and colour are shared by all PowerUps of a kind)
+		for (const PowerUP& powerUp : game.PowerUps)
+			if (!powerUp.Destroyed)
+				this->sprites->DrawSprite(*this->powerUpTextures[powerUp.Type], powerUp.Position, POWERUP_SIZE, 0.0f, POWERUP_KINDS[powerUp.Type].Colour);
+		// draw particles
+		const BallObject& ball = game.Ball;
+		if (!ball.Stuck)
+			this->particles->Draw(game.Particles.GetParticles());
+		// draw ball
+		this->sprites->DrawSprite(ResourceManager::GetTexture("face"), ball.Position, ball.Size, game.BallAppearance.Rotation, game.BallAppearance.Colour);
+		// end rendering to postprocessing framebuffer
+		this->effects->EndRender();
+		// render postprocessing quad with the effects the game enabled
+		this->effects->Confuse = game.Effects.Confuse;
+		this->effects->Chaos = game.Effects.Chaos;
+		this->effects->Shake = game.Effects.Shake;
+		this->effects->Render(time);
+		// render text (don't include in postprocessing)
+		std::stringstream ss1, ss2; ss1 << game.Lives; ss2 << game.Level;
+		this->text->RenderText("Lives: " + ss1.str(), 15.0f, 15.0f, 1.0f);
+		this->text->RenderText("Level: " + ss2.str(), 2100.0f, 15.0f, 1.0f);
+	}
+	if (game.State == GAME_MENU)
+	{
+		this->text->RenderText("Press SPACE to start", 900.0f, this->height / 2.0f + 5.0f, 0.8f);
+		this->text->RenderText("Press W or S to select level", 800.0f, this->height / 2.0f + 80.0f, 0.8f);
+	}
+	if (game.State == GAME_WIN)
+	{
+		this->text->RenderText("You WON", 900.0f, this->height / 2.0f, 1.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+		this->text->RenderText("Press LEFT_ALT to retry or ESC to quit", 400.0f, this->height / 2.0f + 75.0f, 1.0f, glm::vec3(1.0f, 1.0f, 0.0f));
+	}
+}
@@ -0,0 +1,36 @@
+#ifndef GAME_RENDERER_H
+#define GAME_RENDERER_H
+
+#include <GLAD/glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "game.h"
+#include "sprite_renderer.h"
+#include "particle_renderer.h"
+#include "post_processor.h"
+#include "text_renderer.h"
+
+// GameRenderer draws the state of a Game. It owns all GL resources
+// (shaders, textures, framebuffers and glyphs), so the Game itself
+// can be simulated without a GL context.
+class GameRenderer
+{
+public:
+	// constructor/destructor
+	GameRenderer(unsigned int width, unsigned int height);
+	~GameRenderer();
+	// load all shaders/textures/fonts (requires a current GL context)
+	void Init();
+	// render the game, time drives the post-processing effects
+	void Render(const Game& game, float time);
+private:
+	unsigned int		width, height;
+	SpriteRenderer*		sprites;
+	ParticleRenderer*	particles;
+	PostProcessor*		effects;
+	TextRenderer*		text;
+	// textures indexed by PowerUpType
+	Texture2D*			powerUpTextures[POWERUP_TYPE_COUNT];
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game.h"
+#include "autopilot.h"
+#include "percentile.h"
+#include "replay.h"
+#include "shared_state.h"
+#include "spectator_stream.h"
+
+// Headless runner: the autopilot plays the game without a window, GL context or
+// sound device and the run is reported as JSON (throughput, per-phase time and
+// step latency percentiles), giving an unattended regression workload. The
+// level after the ones of the catalog is the endless level. A run can be recorded
+// as a replay, and a replay played instead of the autopilot: level, seed and
+// frames then come from the replay, its checksums are verified and seeking back
+// and forth in it is timed. The exit code is 1 if the replay went out of sync.
+// With --spectate the run is broadcast to spectators (see breakout_spectator), with
+// --export its state is published in shared memory every frame, and an agent
+// writing keys into it (see breakout_agent) takes over from the autopilot.
+// usage: breakout_headless [--level N] [--seed S] [--frames F] [--speed unlimited|FACTOR]
+//                          [--chunk-budget BYTES] [--record FILE | --replay FILE]
+//                          [--spectate PORT] [--export NAME]
+
+// Width of the simulated screen
+const unsigned int SCREEN_WIDTH = 2400;
+// Height of the simulated screen
+const unsigned int SCREEN_HEIGHT = 1200;
+// fixed simulation time step
+const float TIME_STEP = 1.0f / 60.0f;
+
+// command line options
+struct Options
+{
+	unsigned int		Level = 0;
+	unsigned long long	Seed = 0;
+	unsigned int		Frames = 3600;
+	double				Speed = 0.0; // multiple of real time, 0 = unlimited
+	size_t				ChunkBudget = CHUNK_BUDGET; // memory for paged in chunks of chunked levels
+	std::string			Record, Replay; // replay files to write / to play
+	unsigned int		SpectatePort = 0; // 0 = no spectators
+	std::string			Export; // name of the shared memory state export
+};
+
+bool ParseOptions(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string flag = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cout << "ERROR::HEADLESS: Missing value for " << flag << std::endl;
+			return false;
+		}
+		const char* value = argv[++i];
+		if (flag == "--level")
+			options.Level = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (flag == "--seed")
+			options.Seed = std::strtoull(value, nullptr, 10);
+		else if (flag == "--frames")
+			options.Frames = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (flag == "--speed")
+			options.Speed = std::strcmp(value, "unlimited") == 0 ? 0.0 : std::atof(value);
+		else if (flag == "--chunk-budget")
+			options.ChunkBudget = static_cast<size_t>(std::strtoull(value, nullptr, 10));
+		else if (flag == "--record")
+			options.Record = value;
+		else if (flag == "--replay")
+			options.Replay = value;
+		else if (flag == "--spectate")
+			options.SpectatePort = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (flag == "--export")
+			options.Export = value;
+		else
+		{
+			std::cout << "ERROR::HEADLESS: Unknown option " << flag << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// one frame of the runner once the keys are set (by the autopilot or a replay); a lost
+// or won game of the previous frame starts over right away
+void Tick(Game& game)
+{
+	if (game.State != GAME_ACTIVE)
+	{
+		game.Effects.Chaos = false;
+		game.State = GAME_ACTIVE;
+	}
+	game.ProcessInput(TIME_STEP);
+	game.Update(TIME_STEP);
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+		return -1;
+
+	Game breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
+	breakout.Seed(options.Seed);
+	breakout.Init();
+	if (options.Level < breakout.Levels.size())
+		breakout.SelectLevel(options.Level);
+	if (options.Level >= breakout.Levels.size() || breakout.Levels[options.Level].Columns == 0)
+	{
+		std::cout << "ERROR::HEADLESS: Failed to load level " << options.Level << std::endl;
+		return -1;
+	}
+	breakout.State = GAME_ACTIVE;
+	breakout.Profiling = true;
+
+	// a replay starts from the snapshot it was recorded from
+	ReplayPlayer player;
+	ReplayRecorder recorder;
+	bool replaying = !options.Replay.empty(), recording = !options.Record.empty();
+	if (replaying)
+	{
+		if (!player.Load(options.Replay.c_str()) || !player.Start(breakout))
+			return -1;
+		if (player.Header.TimeStep != TIME_STEP)
+		{
+			std::cout << "ERROR::HEADLESS: Replay was recorded with a different time step" << std::endl;
+			return -1;
+		}
+		options.Level = player.Header.Level;
+		options.Seed = player.Header.Seed;
+		options.Frames = player.Header.Frames;
+	}
+	GameLevel& level = breakout.Levels[options.Level];
+	level.Chunks.Budget = options.ChunkBudget;
+	if (recording)
+		recorder.Start(breakout, TIME_STEP);
+
+	Autopilot autopilot;
+	PhaseTimes total = {};
+	std::vector<double> latencies(options.Frames);
+	unsigned int livesLost = 0, gamesLost = 0, gamesWon = 0;
+	unsigned long long collisionBytes = 0, bricksDestroyed = 0;
+	size_t residentBytes = 0;
+	breakout.OnBrickDestroyed([&](const GameLevel&, unsigned int) { ++bricksDestroyed; });
+	std::unique_ptr<SpectatorServer> spectators;
+	if (options.SpectatePort != 0)
+	{
+		spectators = std::make_unique<SpectatorServer>();
+		if (!spectators->Start(static_cast<uint16_t>(options.SpectatePort)))
+		{
+			std::cout << "ERROR::HEADLESS: Failed to listen for spectators on port " << options.SpectatePort << std::endl;
+			return -1;
+		}
+		breakout.OnBrickDestroyed([&](const GameLevel&, unsigned int cell) { spectators->BrickDestroyed(cell); });
+	}
+	SharedStateExport exported;
+	if (!options.Export.empty() && !exported.Open(options.Export.c_str()))
+	{
+		std::cout << "ERROR::HEADLESS: Failed to create the state export " << options.Export << std::endl;
+		return -1;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int frame = 0; frame < options.Frames; ++frame)
+	{
+		std::chrono::steady_clock::time_point stepStart = std::chrono::steady_clock::now();
+		unsigned int lives = breakout.Lives;
+		if (replaying)
+			player.Advance(breakout, Tick);
+		else
+		{
+			if (!exported.IsOpen() || !exported.ReadAgentInput(breakout))
+				autopilot.Control(breakout);
+			if (recording)
+				recorder.Record(breakout);
+			Tick(breakout);
+			if (recording)
+				recorder.EndFrame(breakout);
+		}
+		if (spectators)
+			spectators->Publish(breakout);
+		if (exported.IsOpen())
+			exported.Publish(breakout, frame);
+		std::chrono::steady_clock::time_point stepEnd = std::chrono::steady_clock::now();
+		latencies[frame] = std::chrono::duration<double>(stepEnd - stepStart).count();
+
+		total.Move += breakout.Phases.Move;
+		total.Streaming += breakout.Phases.Streaming;
+		total.Collisions += breakout.Phases.Collisions;
+		total.Events += breakout.Phases.Events;
+		total.Particles += breakout.Phases.Particles;
+		total.PowerUps += breakout.Phases.PowerUps;
+		collisionBytes += breakout.CollisionBytes;
+		residentBytes = std::max(residentBytes, level.Chunks.ResidentBytes());
+		if (breakout.Lives < lives)
+			++livesLost;
+		// back in the menu (lost) or won, the next frame starts over
+		if (breakout.State == GAME_MENU)
+			++gamesLost, ++livesLost;
+		if (breakout.State == GAME_WIN)
+			++gamesWon;
+		// pace the simulation when not running at unlimited speed
+		if (options.Speed > 0.0)
+			std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double>((frame + 1) * TIME_STEP / options.Speed)));
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (spectators)
+		spectators->Stop();
+	bool exporting = exported.IsOpen();
+	exported.Close();
+
+	if (recording && !recorder.Save(options.Record.c_str(), breakout))
+	{
+		std::cout << "ERROR::HEADLESS: Failed to write replay " << options.Record << std::endl;
+		return -1;
+	}
+	// seek back to the middle (from a keyframe) and forward to the end again, which
+	// checks the last checksum a second time
+	double seekBack = 0.0, seekForward = 0.0;
+	if (replaying)
+	{
+		unsigned long long destroyed = bricksDestroyed;
+		std::chrono::steady_clock::time_point seekStart = std::chrono::steady_clock::now();
+		player.Seek(breakout, options.Frames / 2, Tick);
+		std::chrono::steady_clock::time_point seekMiddle = std::chrono::steady_clock::now();
+		player.Seek(breakout, options.Frames, Tick);
+		seekBack = std::chrono::duration<double>(seekMiddle - seekStart).count();
+		seekForward = std::chrono::duration<double>(std::chrono::steady_clock::now() - seekMiddle).count();
+		bricksDestroyed = destroyed;
+	}
+
+	// report (times in microseconds)
+	const double us = 1e6;
+	double frames = std::max(1u, options.Frames);
+	std::cout << "{" << std::endl
+		<< "  \"level\": " << options.Level << "," << std::endl
+		<< "  \"seed\": " << options.Seed << "," << std::endl
+		<< "  \"frames\": " << options.Frames << "," << std::endl
+		<< "  \"seconds\": " << seconds << "," << std::endl
+		<< "  \"frames_per_second\": " << options.Frames / seconds << "," << std::endl
+		<< "  \"lives_lost\": " << livesLost << "," << std::endl
+		<< "  \"games_lost\": " << gamesLost << "," << std::endl
+		<< "  \"games_won\": " << gamesWon << "," << std::endl
+		<< "  \"bricks_destroyed\": " << bricksDestroyed << "," << std::endl
+		<< "  \"phase_us_per_frame\": {"
+		<< "\"move\": " << total.Move * us / frames
+		<< ", \"streaming\": " << total.Streaming * us / frames
+		<< ", \"collisions\": " << total.Collisions * us / frames
+		<< ", \"events\": " << total.Events * us / frames
+		<< ", \"powerups\": " << total.PowerUps * us / frames
+		<< ", \"particles\": " << total.Particles * us / frames << "}," << std::endl
+		<< "  \"collision_bytes_per_frame\": " << collisionBytes / frames << "," << std::endl
+		<< "  \"chunks\": {"
+		<< "\"loads\": " << level.Chunks.Loads
+		<< ", \"evictions\": " << level.Chunks.Evictions
+		<< ", \"peak_resident_bytes\": " << residentBytes << "}," << std::endl
+		<< "  \"step_latency_us\": {"
+		<< "\"p50\": " << Percentile(latencies, 50.0) * us
+		<< ", \"p99\": " << Percentile(latencies, 99.0) * us
+		<< ", \"p99.9\": " << Percentile(latencies, 99.9) * us
+		<< ", \"max\": " << Percentile(latencies, 100.0) * us << "}";
+	if (recording)
+		std::cout << "," << std::endl << "  \"recorded\": {"
+			<< "\"input_bytes\": " << recorder.Input.size()
+			<< ", \"checksums\": " << recorder.Checksums.size() << "}";
+	if (spectators)
+		std::cout << "," << std::endl << "  \"spectators\": {"
+			<< "\"attached\": " << spectators->Attached
+			<< ", \"keyframes\": " << spectators->Keyframes
+			<< ", \"skipped_frames\": " << spectators->Skipped
+			<< ", \"bytes_per_frame\": " << spectators->EncodedBytes / frames << "}";
+	if (exporting)
+		std::cout << "," << std::endl << "  \"export\": {"
+			<< "\"agent_inputs\": " << exported.AgentInputs
+			<< ", \"round_trip_us\": {\"mean\": " << exported.RoundTrip * us / std::max(1u, exported.AgentInputs)
+			<< ", \"max\": " << exported.MaxRoundTrip * us << "}}";
+	if (replaying)
+		std::cout << "," << std::endl << "  \"replay\": {"
+			<< "\"input_bytes\": " << player.Input.size()
+			<< ", \"desync_frame\": " << player.DesyncFrame
+			<< ", \"seek_back_us\": " << seekBack * us
+			<< ", \"seek_forward_us\": " << seekForward * us << "}";
+	std::cout << std::endl << "}" << std::endl;
+	if (replaying && player.DesyncFrame >= 0)
+	{
+		std::cout << "ERROR::HEADLESS: Replay out of sync at frame " << player.DesyncFrame << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,28 @@
+#include "irrklang_audio_player.h"
+
+// sound files, indexed by Sound
+static const char* SOUND_FILES[] =
+{
+	"audio/breakout.mp3",	// SOUND_MUSIC
+	"audio/bleep.mp3",		// SOUND_BLEEP_BRICK
+	"audio/bleep.wav",		// SOUND_BLEEP_PADDLE
+	"audio/solid.wav",		// SOUND_SOLID
+	"audio/powerup.wav"		// SOUND_POWERUP
+};
+
+IrrKlangAudioPlayer::IrrKlangAudioPlayer()
+	: engine(irrklang::createIrrKlangDevice())
+{
+}
+
+IrrKlangAudioPlayer::~IrrKlangAudioPlayer()
+{
+	if (this->engine)
+		this->engine->drop();
+}
+
+void IrrKlangAudioPlayer::Play(Sound sound, bool loop)
+{
+	if (this->engine)
+		this->engine->play2D(SOUND_FILES[sound], loop);
+}
@@ -0,0 +1,21 @@
+#ifndef IRRKLANG_AUDIO_PLAYER_H
+#define IRRKLANG_AUDIO_PLAYER_H
+
+#include <irrklang/irrKlang.h>
+
+#include "audio_player.h"
+
+// AudioPlayer backed by an irrKlang sound device
+class IrrKlangAudioPlayer : public AudioPlayer
+{
+public:
+	// constructor/destructor
+	IrrKlangAudioPlayer();
+	~IrrKlangAudioPlayer();
+	// plays the file that belongs to the given sound
+	void Play(Sound sound, bool loop = false) override;
+private:
+	irrklang::ISoundEngine* engine;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "level_catalog.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+// adds the level file to the catalog if it exists
+bool AddLevel(std::vector<LevelInfo>& levels, const fs::path& path)
+{
+	std::error_code error;
+	uintmax_t bytes = fs::file_size(path, error);
+	if (error)
+		return false;
+	levels.push_back({ path.stem().string(), path.string(), bytes });
+	return true;
+}
+
+int LevelCatalog::Find(const std::string& path) const
+{
+	fs::path wanted = fs::path(path).lexically_normal();
+	for (unsigned int i = 0; i < this->Levels.size(); ++i)
+		if (fs::path(this->Levels[i].Path).lexically_normal() == wanted)
+			return static_cast<int>(i);
+	return -1;
+}
+
+bool LevelCatalog::Scan(const char* directory)
+{
+	this->Levels.clear();
+	fs::path root(directory);
+	std::ifstream index(root / LEVEL_INDEX_FILE);
+	if (index)
+	{
+		std::string line;
+		while (std::getline(index, line))
+		{
+			// ignore blank lines and windows line endings
+			line.erase(line.find_last_not_of(" \t\r") + 1);
+			if (line.empty())
+				continue;
+			if (!AddLevel(this->Levels, root / line))
+				std::cout << "ERROR::LEVEL: Level listed in index not found: " << line << std::endl;
+		}
+	}
+	else
+	{
+		std::error_code error;
+		std::vector<fs::path> files;
+		for (const fs::directory_entry& entry : fs::directory_iterator(root, error))
+		{
+			std::string extension = entry.path().extension().string();
+			if (entry.is_regular_file() && (extension == ".lvl" || extension == ".lvlb" || extension == ".lvlc"))
+				files.push_back(entry.path());
+		}
+		std::sort(files.begin(), files.end());
+		for (const fs::path& file : files)
+			AddLevel(this->Levels, file);
+	}
+	if (this->Levels.empty())
+	{
+		std::cout << "ERROR::LEVEL: No levels found in " << directory << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,36 @@
+#ifndef LEVEL_CATALOG_H
+#define LEVEL_CATALOG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// file listing the levels of a directory in play order, one file name per line
+const char* const LEVEL_INDEX_FILE = "index.txt";
+
+// metadata of a level file, known without parsing the level
+struct LevelInfo
+{
+	std::string	Name;	// file name without extension
+	std::string	Path;
+	uintmax_t	Bytes;	// file size
+};
+
+// LevelCatalog lists the levels that ship in a directory. Only names
+// and file sizes are read, so scanning stays cheap however many levels
+// there are; the levels themselves are parsed on demand (see Game::SelectLevel).
+class LevelCatalog
+{
+public:
+	// known levels in play order
+	std::vector<LevelInfo> Levels;
+	// lists the levels of the directory: the ones named by its index file if
+	// there is one, otherwise all .lvl, .lvlb and .lvlc files sorted by name
+	bool Scan(const char* directory);
+	// number of levels
+	unsigned int Size() const { return static_cast<unsigned int>(this->Levels.size()); }
+	// index of the level stored at path, -1 if it is not part of the catalog
+	int Find(const std::string& path) const;
+};
+
+#endif
\ No newline at end of file
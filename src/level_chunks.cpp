@@ -0,0 +1,274 @@
+#include "level_chunks.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// memory a paged in chunk costs: its page of tile codes and its bitmap
+const size_t CHUNK_COST = LEVEL_CHUNK_BYTES + sizeof(ChunkBits);
+
+// brick bitmap of a chunk as stored, built a row at a time without branches
+ChunkBits BuildChunkBits(const uint8_t* tiles)
+{
+	ChunkBits bits;
+	for (unsigned int row = 0; row < LEVEL_CHUNK_SIZE; ++row, tiles += LEVEL_CHUNK_SIZE)
+	{
+		uint64_t word = 0;
+		for (unsigned int i = 0; i < LEVEL_CHUNK_SIZE; ++i)
+			word |= uint64_t(tiles[i] != 0) << i;
+		bits[row] = word;
+	}
+	return bits;
+}
+
+// squared distance between the centre of a chunk and a point (in chunks)
+float ChunkDistance(unsigned int chunk, unsigned int chunksX, glm::vec2 point)
+{
+	glm::vec2 offset = glm::vec2(chunk % chunksX, chunk / chunksX) - point;
+	return glm::dot(offset, offset);
+}
+
+LevelChunks::LevelChunks()
+	: Columns(0), Rows(0), ChunksX(0), ChunksY(0), Budget(CHUNK_BUDGET), Loads(0), Evictions(0),
+	  wantedMin(1), wantedMax(0)
+{
+}
+
+bool LevelChunks::Open(const char* file, unsigned int& bricks)
+{
+	this->Close();
+	// chunks are read where the camera goes, not front to back
+	std::shared_ptr<MappedFile> map = std::make_shared<MappedFile>();
+	ChunkedLevelHeader header;
+	if (!map->Open(file, false) || map->Size() < sizeof(header))
+		return false;
+	std::memcpy(&header, map->Data(), sizeof(header));
+	if (std::memcmp(header.Magic, "LVLC", 4) != 0)
+		return false;
+	size_t chunksX = (static_cast<size_t>(header.Columns) + LEVEL_CHUNK_SIZE - 1) / LEVEL_CHUNK_SIZE;
+	size_t chunksY = (static_cast<size_t>(header.Rows) + LEVEL_CHUNK_SIZE - 1) / LEVEL_CHUNK_SIZE;
+	// cells are numbered with 32 bits
+	if (header.Version != CHUNKED_LEVEL_VERSION || chunksX * chunksY == 0
+		|| static_cast<unsigned long long>(header.Columns) * header.Rows > UINT_MAX
+		|| map->Size() / LEVEL_CHUNK_BYTES < chunksX * chunksY + 1)
+	{
+		std::cout << "ERROR::LEVEL: Unsupported or truncated chunked level file" << std::endl;
+		return false;
+	}
+	// the header page is not needed again
+	map->Release(0, LEVEL_CHUNK_BYTES);
+	this->file = map;
+	this->Columns = header.Columns;
+	this->Rows = header.Rows;
+	this->ChunksX = static_cast<unsigned int>(chunksX);
+	this->ChunksY = static_cast<unsigned int>(chunksY);
+	bricks = header.Bricks;
+	return true;
+}
+
+void LevelChunks::Close()
+{
+	this->resident.clear();
+	this->loading.clear();
+	this->destroyed.clear();
+	this->file.reset();
+	this->Columns = this->Rows = this->ChunksX = this->ChunksY = 0;
+	this->Loads = this->Evictions = 0;
+	this->wantedMin = glm::ivec2(1);
+	this->wantedMax = glm::ivec2(0);
+}
+
+bool LevelChunks::IsLive(unsigned int cell) const
+{
+	unsigned int x = cell % this->Columns, y = cell / this->Columns;
+	unsigned int chunk = y / LEVEL_CHUNK_SIZE * this->ChunksX + x / LEVEL_CHUNK_SIZE;
+	unsigned int row = y % LEVEL_CHUNK_SIZE;
+	uint64_t bit = uint64_t(1) << (x % LEVEL_CHUNK_SIZE);
+	if (const ChunkBits* bits = this->Find(chunk))
+		return ((*bits)[row] & bit) != 0;
+	std::unordered_map<uint32_t, ChunkBits>::const_iterator delta = this->destroyed.find(chunk);
+	return this->Tile(cell) != 0 && (delta == this->destroyed.end() || (delta->second[row] & bit) == 0);
+}
+
+void LevelChunks::Destroy(unsigned int cell)
+{
+	unsigned int x = cell % this->Columns, y = cell / this->Columns;
+	unsigned int chunk = y / LEVEL_CHUNK_SIZE * this->ChunksX + x / LEVEL_CHUNK_SIZE;
+	unsigned int row = y % LEVEL_CHUNK_SIZE;
+	uint64_t bit = uint64_t(1) << (x % LEVEL_CHUNK_SIZE);
+	assert(this->Find(chunk));
+	this->resident[chunk][row] &= ~bit;
+	// the delta of a chunk is created with its first destroyed brick
+	this->destroyed.try_emplace(chunk).first->second[row] |= bit;
+}
+
+void LevelChunks::Stream(glm::ivec2 requiredMin, glm::ivec2 requiredMax, glm::ivec2 wantedMin, glm::ivec2 wantedMax)
+{
+	if (!this->IsOpen())
+		return;
+	// take over finished background loads that are still wanted
+	for (auto it = this->loading.begin(); it != this->loading.end();)
+	{
+		if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+		glm::ivec2 position(it->first % this->ChunksX, it->first / this->ChunksX);
+		if (glm::all(glm::greaterThanEqual(position, wantedMin)) && glm::all(glm::lessThanEqual(position, wantedMax)))
+			this->pageIn(it->first, it->second.get());
+		it = this->loading.erase(it);
+	}
+	// the chunks under the ball are needed by this frame's collisions
+	size_t required = 0;
+	for (int y = requiredMin.y; y <= requiredMax.y; ++y)
+		for (int x = requiredMin.x; x <= requiredMax.x; ++x, ++required)
+		{
+			unsigned int chunk = y * this->ChunksX + x;
+			if (this->resident.count(chunk))
+				continue;
+			auto pending = this->loading.find(chunk);
+			if (pending != this->loading.end())
+			{
+				this->pageIn(chunk, pending->second.get());
+				this->loading.erase(pending);
+			}
+			else
+				this->pageIn(chunk, BuildChunkBits(this->chunkTiles(chunk)));
+		}
+	size_t capacity = std::max(this->Budget / CHUNK_COST, required);
+	glm::vec2 centre = glm::vec2(wantedMin + wantedMax) / 2.0f;
+	// request the wanted chunks nearest first once the camera reaches other chunks
+	if (wantedMin != this->wantedMin || wantedMax != this->wantedMax)
+	{
+		this->wantedMin = wantedMin;
+		this->wantedMax = wantedMax;
+		std::vector<unsigned int> wanted;
+		for (int y = wantedMin.y; y <= wantedMax.y; ++y)
+			for (int x = wantedMin.x; x <= wantedMax.x; ++x)
+				wanted.push_back(y * this->ChunksX + x);
+		std::sort(wanted.begin(), wanted.end(), [&](unsigned int a, unsigned int b)
+		{
+			float distanceA = ChunkDistance(a, this->ChunksX, centre), distanceB = ChunkDistance(b, this->ChunksX, centre);
+			return distanceA < distanceB || (distanceA == distanceB && a < b);
+		});
+		wanted.resize(std::min(wanted.size(), capacity));
+		for (unsigned int chunk : wanted)
+		{
+			if (this->resident.count(chunk) || this->loading.count(chunk))
+				continue;
+			std::shared_ptr<const MappedFile> file = this->file;
+			const uint8_t* tiles = this->chunkTiles(chunk);
+			this->loading[chunk] = std::async(std::launch::async, [file, tiles]()
+			{
+				// reading the tiles pages them in on this thread
+				return BuildChunkBits(tiles);
+			}).share();
+		}
+	}
+	// enforce the budget, farthest chunks first (never the ones under the ball)
+	if (this->resident.size() + this->loading.size() <= capacity)
+		return;
+	std::vector<unsigned int> evictable;
+	for (const auto& chunk : this->resident)
+	{
+		glm::ivec2 position(chunk.first % this->ChunksX, chunk.first / this->ChunksX);
+		if (!glm::all(glm::greaterThanEqual(position, requiredMin)) || !glm::all(glm::lessThanEqual(position, requiredMax)))
+			evictable.push_back(chunk.first);
+	}
+	std::sort(evictable.begin(), evictable.end(), [&](unsigned int a, unsigned int b)
+	{
+		float distanceA = ChunkDistance(a, this->ChunksX, centre), distanceB = ChunkDistance(b, this->ChunksX, centre);
+		return distanceA > distanceB || (distanceA == distanceB && a < b);
+	});
+	for (unsigned int chunk : evictable)
+	{
+		if (this->resident.size() + this->loading.size() <= capacity)
+			break;
+		this->pageOut(chunk);
+	}
+}
+
+void LevelChunks::Reset()
+{
+	this->destroyed.clear();
+	for (auto& chunk : this->resident)
+		chunk.second = BuildChunkBits(this->chunkTiles(chunk.first));
+}
+
+unsigned int LevelChunks::Destroyed() const
+{
+	unsigned int count = 0;
+	for (const auto& delta : this->destroyed)
+		for (uint64_t word : delta.second)
+			count += std::popcount(word);
+	return count;
+}
+
+void LevelChunks::SaveDeltas(uint8_t* data) const
+{
+	// in chunk order, so the same damage always saves to the same bytes
+	std::vector<uint32_t> chunks;
+	chunks.reserve(this->destroyed.size());
+	for (const auto& delta : this->destroyed)
+		chunks.push_back(delta.first);
+	std::sort(chunks.begin(), chunks.end());
+	for (uint32_t chunk : chunks)
+	{
+		std::memcpy(data, &chunk, sizeof(chunk));
+		std::memcpy(data + sizeof(chunk), this->destroyed.at(chunk).data(), sizeof(ChunkBits));
+		data += CHUNK_DELTA_BYTES;
+	}
+}
+
+void LevelChunks::RestoreDeltas(const uint8_t* data, unsigned int count)
+{
+	std::unordered_map<uint32_t, ChunkBits> previous;
+	previous.swap(this->destroyed);
+	for (unsigned int i = 0; i < count; ++i, data += CHUNK_DELTA_BYTES)
+	{
+		uint32_t chunk;
+		std::memcpy(&chunk, data, sizeof(chunk));
+		std::memcpy(this->destroyed[chunk].data(), data + sizeof(chunk), sizeof(ChunkBits));
+	}
+	// paged in chunks get back the bricks only the previous delta had destroyed and lose
+	// the ones of the new delta (chunks being loaded apply the delta when paged in)
+	const ChunkBits none = {};
+	for (auto& chunk : this->resident)
+	{
+		std::unordered_map<uint32_t, ChunkBits>::const_iterator before = previous.find(chunk.first);
+		std::unordered_map<uint32_t, ChunkBits>::const_iterator after = this->destroyed.find(chunk.first);
+		const ChunkBits& restored = before != previous.end() ? before->second : none;
+		const ChunkBits& destroyed = after != this->destroyed.end() ? after->second : none;
+		for (unsigned int row = 0; row < LEVEL_CHUNK_SIZE; ++row)
+			chunk.second[row] = (chunk.second[row] | restored[row]) & ~destroyed[row];
+	}
+}
+
+size_t LevelChunks::ResidentBytes() const
+{
+	return (this->resident.size() + this->loading.size()) * CHUNK_COST;
+}
+
+void LevelChunks::pageIn(unsigned int chunk, const ChunkBits& pristine)
+{
+	ChunkBits& bits = this->resident[chunk];
+	bits = pristine;
+	std::unordered_map<uint32_t, ChunkBits>::const_iterator delta = this->destroyed.find(chunk);
+	if (delta != this->destroyed.end())
+		for (unsigned int row = 0; row < LEVEL_CHUNK_SIZE; ++row)
+			bits[row] &= ~delta->second[row];
+	++this->Loads;
+}
+
+void LevelChunks::pageOut(unsigned int chunk)
+{
+	this->resident.erase(chunk);
+	// copies of the level share the mapping, they page it back in when they touch it
+	this->file->Release(static_cast<size_t>(chunk + 1) * LEVEL_CHUNK_BYTES, LEVEL_CHUNK_BYTES);
+	++this->Evictions;
+}
\ No newline at end of file
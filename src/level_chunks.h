@@ -0,0 +1,113 @@
+#ifndef LEVEL_CHUNKS_H
+#define LEVEL_CHUNKS_H
+
+#include <array>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "mapped_file.h"
+
+// header of a chunked level file (.lvlc), padded to LEVEL_CHUNK_BYTES and followed
+// by the chunks in row major order, each LEVEL_CHUNK_SIZE rows of LEVEL_CHUNK_SIZE
+// tile codes (cells past the grid are empty); fields are stored little endian
+struct ChunkedLevelHeader
+{
+	char		Magic[4];	// "LVLC"
+	uint32_t	Version;
+	uint32_t	Columns, Rows;
+	uint32_t	Bricks;		// destructible bricks of the whole level
+};
+const uint32_t CHUNKED_LEVEL_VERSION = 1;
+
+// width and height of a chunk in cells, a chunk row is a single bitmap word
+const unsigned int LEVEL_CHUNK_SIZE = 64;
+// tile codes per chunk, chunks start at multiples of it in the file (a page each)
+const unsigned int LEVEL_CHUNK_BYTES = LEVEL_CHUNK_SIZE * LEVEL_CHUNK_SIZE;
+// default memory for the chunks paged in at once (tile codes and bitmaps)
+const size_t CHUNK_BUDGET = 1 << 20;
+
+// a bit per cell of a chunk, a word per chunk row
+typedef std::array<uint64_t, LEVEL_CHUNK_SIZE> ChunkBits;
+// bytes of a saved chunk delta: the chunk number and its destroyed bricks
+const size_t CHUNK_DELTA_BYTES = sizeof(uint32_t) + sizeof(ChunkBits);
+
+// LevelChunks pages the tiles of a chunked level in and out around the camera,
+// so levels of any size play in bounded memory. The file stays mapped: paging
+// a chunk in reads its page on a worker thread and builds its brick bitmap,
+// paging it out drops both. Destroyed bricks are kept as a delta bitmap per
+// damaged chunk, so a chunk paged in again keeps its damage. Chunks are
+// numbered row major, chunk rectangles are given in chunk coordinates with
+// both corners included.
+class LevelChunks
+{
+public:
+	// grid dimensions in cells and in chunks
+	unsigned int	Columns, Rows;
+	unsigned int	ChunksX, ChunksY;
+	// memory for paged in chunks, the chunks under the ball are paged in regardless
+	size_t			Budget;
+	// chunks paged in and out since opening
+	unsigned int	Loads, Evictions;
+	// constructor
+	LevelChunks();
+	// maps a chunked level file and returns its number of destructible bricks in bricks
+	bool Open(const char* file, unsigned int& bricks);
+	// unmaps the file and forgets all chunks (waits for pending loads)
+	void Close();
+	bool IsOpen() const { return this->file != nullptr; }
+	// tile code of a cell, read from the mapping whether its chunk is paged in or not
+	uint8_t Tile(unsigned int cell) const
+	{
+		unsigned int x = cell % this->Columns, y = cell / this->Columns;
+		return this->chunkTiles(y / LEVEL_CHUNK_SIZE * this->ChunksX + x / LEVEL_CHUNK_SIZE)
+			[y % LEVEL_CHUNK_SIZE * LEVEL_CHUNK_SIZE + x % LEVEL_CHUNK_SIZE];
+	}
+	// bitmap of a chunk, nullptr while it is not paged in
+	const ChunkBits* Find(unsigned int chunk) const
+	{
+		std::unordered_map<uint32_t, ChunkBits>::const_iterator it = this->resident.find(chunk);
+		return it != this->resident.end() ? &it->second : nullptr;
+	}
+	// brick state of a cell (its chunk does not need to be paged in)
+	bool IsLive(unsigned int cell) const;
+	// destroys the brick in a cell of a paged in chunk and records it in the chunk's delta
+	void Destroy(unsigned int cell);
+	// pages in the chunks of the required rectangle right away and the ones of the wanted
+	// rectangle in the background (nearest to its centre first), then pages out the
+	// chunks farthest from it until the paged in chunks fit the budget
+	void Stream(glm::ivec2 requiredMin, glm::ivec2 requiredMax, glm::ivec2 wantedMin, glm::ivec2 wantedMax);
+	// forgets all damage
+	void Reset();
+	// destructible bricks destroyed since opening or the last Reset (counted from the deltas)
+	unsigned int Destroyed() const;
+	// memory of the chunks paged in or being paged in
+	size_t ResidentBytes() const;
+	// number of damaged chunks, and their deltas written to / read from data
+	// (CHUNK_DELTA_BYTES each, in chunk order); restoring also updates the paged in chunks
+	unsigned int DeltaCount() const { return static_cast<unsigned int>(this->destroyed.size()); }
+	void SaveDeltas(uint8_t* data) const;
+	void RestoreDeltas(const uint8_t* data, unsigned int count);
+private:
+	// shared by copies of the level, the mapping is never written
+	std::shared_ptr<const MappedFile> file;
+	// bitmaps of the paged in chunks, pending loads and delta bitmaps of damaged chunks
+	std::unordered_map<uint32_t, ChunkBits> resident;
+	std::unordered_map<uint32_t, std::shared_future<ChunkBits>> loading;
+	std::unordered_map<uint32_t, ChunkBits> destroyed;
+	// wanted rectangle of the previous Stream
+	glm::ivec2 wantedMin, wantedMax;
+	// tile codes of a chunk inside the mapping
+	const uint8_t* chunkTiles(unsigned int chunk) const
+	{
+		return reinterpret_cast<const uint8_t*>(this->file->Data()) + static_cast<size_t>(chunk + 1) * LEVEL_CHUNK_BYTES;
+	}
+	// installs the bitmap of a loaded chunk with its damage applied
+	void pageIn(unsigned int chunk, const ChunkBits& pristine);
+	void pageOut(unsigned int chunk);
+};
+
+#endif
\ No newline at end of file
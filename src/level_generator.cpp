@@ -0,0 +1,29 @@
+#include "level_generator.h"
+#include "game_level.h"
+#include "game_random.h"
+#include <algorithm>
+
+std::vector<uint8_t> GenerateTiles(const LevelRecipe& recipe)
+{
+	std::vector<uint8_t> tiles(static_cast<size_t>(recipe.Columns) * recipe.Rows, 0);
+	RandomStream random(recipe.Seed);
+	for (unsigned int y = 0; y < recipe.Rows; ++y)
+		GenerateRow(recipe, random, &tiles[static_cast<size_t>(y) * recipe.Columns]);
+	return tiles;
+}
+
+void GenerateRow(const LevelRecipe& recipe, RandomStream& random, uint8_t* row)
+{
+	// colour codes start after the solid code and have to stay below the text parser's 255
+	uint32_t colours = std::clamp(recipe.Colours, 1u, 255u - TILE_SOLID - 1u);
+	for (unsigned int x = 0; x < recipe.Columns; ++x)
+	{
+		row[x] = 0;
+		if (random.Float() >= recipe.Density)
+			continue;
+		if (random.Float() < recipe.Solid)
+			row[x] = TILE_SOLID;
+		else
+			row[x] = static_cast<uint8_t>(TILE_SOLID + 1 + random.Below(colours));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef LEVEL_GENERATOR_H
+#define LEVEL_GENERATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "game_random.h"
+
+// parameters of a generated level
+struct LevelRecipe
+{
+	unsigned int	Columns, Rows;
+	float			Density;	// share of cells holding a brick
+	float			Solid;		// share of the bricks that are solid
+	unsigned int	Colours;	// destructible bricks use the tile codes 2 .. 1 + Colours
+	uint64_t		Seed;
+};
+
+// recipe of the stress levels: three quarters filled, a tenth of it solid, the four palette colours
+const LevelRecipe DEFAULT_RECIPE = { 100, 100, 0.75f, 0.1f, 4, 0 };
+
+// tile codes of a random level (row major), the same recipe always gives the same level;
+// each cell draws its brick independently so any size and density can be asked for
+std::vector<uint8_t> GenerateTiles(const LevelRecipe& recipe);
+// tile codes of the next row (recipe.Columns codes) of a level drawn from random
+void GenerateRow(const LevelRecipe& recipe, RandomStream& random, uint8_t* row);
+
+#endif
\ No newline at end of file
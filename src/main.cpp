@@ -1,10 +1,18 @@
 #include <GLAD/glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <string>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <vector>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "game.h"
+#include "game_renderer.h"
+#include "irrklang_audio_player.h"
 #include "resource_manager.h"
+#include "file_watcher.h"
+#include "shared_state.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height); // callback function for changing the window 
 
@@ -16,6 +24,8 @@ void processInput(GLFWwindow* window); // function for exit from the window with
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 
+void reloadChangedFiles(FileWatcher& watcher); // hot reload of edited levels and shaders
+
 // debug function
 void APIENTRY glDebugOutput(GLenum source,
 	GLenum type,
@@ -70,7 +80,9 @@ const unsigned int SCREEN_HEIGHT = 1200;
 
 Game Breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
 
-int main()
+// usage: BreakOut [--watch] [--export NAME] (--watch reloads levels and shaders when they
+// are edited, --export publishes the game state in shared memory for external agents)
+int main(int argc, char* argv[])
 
 {
 	//initialize the GLFW library
@@ -106,7 +118,35 @@ int main()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	//initialize game
+	IrrKlangAudioPlayer audio;
+	Breakout.Audio = &audio;
+	Breakout.Seed(static_cast<uint64_t>(std::time(nullptr)));
 	Breakout.Init();
+	GameRenderer* renderer = new GameRenderer(SCREEN_WIDTH, SCREEN_HEIGHT);
+	renderer->Init();
+
+	// optional hot reload while editing levels or shaders
+	bool watch = false;
+	const char* exportName = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--watch") == 0)
+			watch = true;
+		else if (std::strcmp(argv[i], "--export") == 0 && i + 1 < argc)
+			exportName = argv[++i];
+	}
+	FileWatcher watcher;
+	if (watch)
+	{
+		watcher.Watch("levels");
+		watcher.Watch("shaders");
+	}
+
+	// optional state export, an agent writing keys into it plays instead of the keyboard
+	SharedStateExport exported;
+	if (exportName && !exported.Open(exportName))
+		std::cout << "ERROR::EXPORT: Failed to create the state export " << exportName << std::endl;
+	unsigned int frame = 0;
 
 	// deltaTime variables
 	// ------------------
@@ -164,25 +204,32 @@ int main()
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 		glfwPollEvents();
+		if (watch)
+			reloadChangedFiles(watcher);
 
 		// manage user input
 		// -----------------
+		if (exported.IsOpen())
+			exported.ReadAgentInput(Breakout);
 		Breakout.ProcessInput(deltaTime);
 
 		// update game state
 		// -----------------
 		Breakout.Update(deltaTime);
+		if (exported.IsOpen())
+			exported.Publish(Breakout, frame++);
 
 		// render
 		// ------
 
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
-		Breakout.Render();
+		renderer->Render(Breakout, static_cast<float>(glfwGetTime()));
 		
 
 		glfwSwapBuffers(window);
 	}
+	delete renderer;
 	ResourceManager::Clear();
 	glfwTerminate();
 	return 0;
@@ -199,6 +246,22 @@ void processInput(GLFWwindow* window)
 }
 
 
+void reloadChangedFiles(FileWatcher& watcher)
+{
+	static std::vector<std::string> changed;
+	changed.clear();
+	watcher.Poll(changed);
+	for (const std::string& file : changed)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		// only the changed level or the programs using the changed shader are rebuilt
+		bool reloaded = Breakout.ReloadLevel(file) || ResourceManager::ReloadShader(file) > 0;
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (reloaded)
+			std::cout << "RELOAD: " << file << " (" << ms << " ms)" << std::endl;
+	}
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
@@ -0,0 +1,129 @@
+#include "mapped_file.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+	: data(nullptr), size(0), file(INVALID_HANDLE_VALUE), mapping(nullptr)
+{
+}
+
+bool MappedFile::Open(const char* file, bool sequential)
+{
+	this->Close();
+	this->file = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (this->file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(this->file, &size))
+	{
+		this->Close();
+		return false;
+	}
+	this->size = static_cast<size_t>(size.QuadPart);
+	if (this->size == 0)
+		return true;
+	this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (this->mapping)
+		this->data = static_cast<const char*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!this->data)
+	{
+		this->Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (this->data)
+		UnmapViewOfFile(this->data);
+	if (this->mapping)
+		CloseHandle(this->mapping);
+	if (this->file != INVALID_HANDLE_VALUE)
+		CloseHandle(this->file);
+	this->data = nullptr;
+	this->size = 0;
+	this->mapping = nullptr;
+	this->file = INVALID_HANDLE_VALUE;
+}
+
+void MappedFile::Release(size_t offset, size_t size) const
+{
+	// the working set of a read-only view is trimmed by the system
+}
+
+#else
+
+MappedFile::MappedFile()
+	: data(nullptr), size(0)
+{
+}
+
+bool MappedFile::Open(const char* file, bool sequential)
+{
+	this->Close();
+	int fd = open(file, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	this->size = static_cast<size_t>(info.st_size);
+	if (this->size > 0)
+	{
+		void* data = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			close(fd);
+			this->size = 0;
+			return false;
+		}
+		// the file is read front to back exactly once, or in pieces where needed
+		madvise(data, this->size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+		this->data = static_cast<const char*>(data);
+	}
+	// the mapping stays valid after closing the descriptor
+	close(fd);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (this->data)
+		munmap(const_cast<char*>(this->data), this->size);
+	this->data = nullptr;
+	this->size = 0;
+}
+
+void MappedFile::Release(size_t offset, size_t size) const
+{
+	// round inwards to whole pages, madvise only takes page aligned ranges
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t begin = (offset + page - 1) / page * page;
+	size_t end = std::min(offset + size, this->size) / page * page;
+	if (this->data && begin < end)
+		madvise(const_cast<char*>(this->data) + begin, end - begin, MADV_DONTNEED);
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	this->Close();
+}
@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+// MappedFile maps a whole file read-only into memory, so it can be parsed
+// in place without copying it into a buffer first. The mapping lives as
+// long as the object.
+class MappedFile
+{
+public:
+	// constructor/destructor
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	// maps the file, returns false if it can't be opened (empty files map to no data);
+	// sequential files are read ahead, others are paged in where they are touched
+	bool Open(const char* file, bool sequential = true);
+	// unmaps the file
+	void Close();
+	// mapped contents
+	const char* Data() const { return this->data; }
+	size_t Size() const { return this->size; }
+	// hands the pages of a range back to the system, they are read again once touched
+	// (only whole pages inside the range are released)
+	void Release(size_t offset, size_t size) const;
+private:
+	const char*	data;
+	size_t		size;
+#ifdef _WIN32
+	void*		file;
+	void*		mapping;
+#endif
+};
+
+#endif
\ No newline at end of file
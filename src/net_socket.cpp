@@ -0,0 +1,260 @@
+#include "net_socket.h"
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET NativeSocket;
+const intptr_t INVALID_HANDLE = static_cast<intptr_t>(INVALID_SOCKET);
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int NativeSocket;
+const intptr_t INVALID_HANDLE = -1;
+#endif
+
+// writes to a closed connection fail instead of raising SIGPIPE
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+// the platform's socket type of a handle
+NativeSocket Native(intptr_t handle)
+{
+	return static_cast<NativeSocket>(handle);
+}
+
+// address of a port on 127.0.0.1
+sockaddr_in LoopbackAddress(uint16_t port)
+{
+	sockaddr_in address;
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	return address;
+}
+
+// creates a socket, returns INVALID_HANDLE on failure
+intptr_t OpenSocket(int type, int protocol)
+{
+#ifdef _WIN32
+	// winsock is started once for the process and never cleaned up
+	static bool started = [] { WSADATA data; return WSAStartup(MAKEWORD(2, 2), &data) == 0; }();
+	if (!started)
+		return INVALID_HANDLE;
+#endif
+	return static_cast<intptr_t>(socket(AF_INET, type, protocol));
+}
+
+void CloseSocket(intptr_t handle)
+{
+	if (handle == INVALID_HANDLE)
+		return;
+#ifdef _WIN32
+	closesocket(Native(handle));
+#else
+	close(Native(handle));
+#endif
+}
+
+bool SetNonBlocking(intptr_t handle)
+{
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	return ioctlsocket(Native(handle), FIONBIO, &nonBlocking) == 0;
+#else
+	return fcntl(Native(handle), F_SETFL, O_NONBLOCK) == 0;
+#endif
+}
+
+// binds a socket to a port of 127.0.0.1 and returns the port it got (0 on failure)
+uint16_t BindLoopback(intptr_t handle, uint16_t port)
+{
+	sockaddr_in address = LoopbackAddress(port);
+	socklen_t length = sizeof(address);
+	if (bind(Native(handle), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+		|| getsockname(Native(handle), reinterpret_cast<sockaddr*>(&address), &length) != 0)
+		return 0;
+	return ntohs(address.sin_port);
+}
+
+// true if the last call on a non-blocking socket failed only because it would block
+bool WouldBlock()
+{
+#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+UdpSocket::UdpSocket()
+	: handle(INVALID_HANDLE), port(0)
+{
+}
+
+UdpSocket::~UdpSocket()
+{
+	this->Close();
+}
+
+bool UdpSocket::Open(uint16_t port)
+{
+	this->Close();
+	this->handle = OpenSocket(SOCK_DGRAM, IPPROTO_UDP);
+	if (this->handle == INVALID_HANDLE)
+		return false;
+	this->port = SetNonBlocking(this->handle) ? BindLoopback(this->handle, port) : 0;
+	if (this->port == 0)
+	{
+		this->Close();
+		return false;
+	}
+	return true;
+}
+
+void UdpSocket::Close()
+{
+	CloseSocket(this->handle);
+	this->handle = INVALID_HANDLE;
+	this->port = 0;
+}
+
+bool UdpSocket::IsOpen() const
+{
+	return this->handle != INVALID_HANDLE;
+}
+
+bool UdpSocket::Send(uint16_t port, const void* data, size_t size)
+{
+	sockaddr_in address = LoopbackAddress(port);
+	return sendto(Native(this->handle), static_cast<const char*>(data), static_cast<int>(size), 0,
+		reinterpret_cast<sockaddr*>(&address), sizeof(address)) == static_cast<int>(size);
+}
+
+int UdpSocket::Receive(void* data, size_t size)
+{
+	int received = static_cast<int>(recv(Native(this->handle), static_cast<char*>(data), static_cast<int>(size), 0));
+	return received >= 0 ? received : -1;
+}
+
+TcpSocket::TcpSocket()
+	: handle(INVALID_HANDLE), port(0)
+{
+}
+
+TcpSocket::~TcpSocket()
+{
+	this->Close();
+}
+
+TcpSocket::TcpSocket(TcpSocket&& other) noexcept
+	: handle(std::exchange(other.handle, INVALID_HANDLE)), port(std::exchange(other.port, 0))
+{
+}
+
+TcpSocket& TcpSocket::operator=(TcpSocket&& other) noexcept
+{
+	if (this != &other)
+	{
+		this->Close();
+		this->handle = std::exchange(other.handle, INVALID_HANDLE);
+		this->port = std::exchange(other.port, 0);
+	}
+	return *this;
+}
+
+bool TcpSocket::Listen(uint16_t port)
+{
+	this->Close();
+	this->handle = OpenSocket(SOCK_STREAM, IPPROTO_TCP);
+	if (this->handle == INVALID_HANDLE)
+		return false;
+	int reuse = 1;
+	setsockopt(Native(this->handle), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+	this->port = SetNonBlocking(this->handle) ? BindLoopback(this->handle, port) : 0;
+	if (this->port == 0 || listen(Native(this->handle), SOMAXCONN) != 0)
+	{
+		this->Close();
+		return false;
+	}
+	return true;
+}
+
+bool TcpSocket::Accept(TcpSocket& client)
+{
+	intptr_t handle = static_cast<intptr_t>(accept(Native(this->handle), nullptr, nullptr));
+	if (handle == INVALID_HANDLE)
+		return false;
+	client.Close();
+	client.handle = handle;
+	client.port = this->port;
+	client.configure();
+	return true;
+}
+
+bool TcpSocket::Connect(uint16_t port)
+{
+	this->Close();
+	this->handle = OpenSocket(SOCK_STREAM, IPPROTO_TCP);
+	if (this->handle == INVALID_HANDLE)
+		return false;
+	// connecting on the loopback interface does not wait on anything
+	sockaddr_in address = LoopbackAddress(port);
+	if (connect(Native(this->handle), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		this->Close();
+		return false;
+	}
+	this->port = port;
+	this->configure();
+	return true;
+}
+
+void TcpSocket::Close()
+{
+	CloseSocket(this->handle);
+	this->handle = INVALID_HANDLE;
+	this->port = 0;
+}
+
+bool TcpSocket::IsOpen() const
+{
+	return this->handle != INVALID_HANDLE;
+}
+
+int TcpSocket::Send(const void* data, size_t size)
+{
+	int sent = static_cast<int>(send(Native(this->handle), static_cast<const char*>(data), static_cast<int>(size), SEND_FLAGS));
+	if (sent >= 0)
+		return sent;
+	return WouldBlock() ? 0 : -1;
+}
+
+int TcpSocket::Receive(void* data, size_t size)
+{
+	int received = static_cast<int>(recv(Native(this->handle), static_cast<char*>(data), static_cast<int>(size), 0));
+	if (received > 0)
+		return received;
+	// 0 bytes: the peer closed the connection
+	return received < 0 && WouldBlock() ? 0 : -1;
+}
+
+void TcpSocket::configure()
+{
+	// frames are small and sent as they are produced, so they are not held back
+	int noDelay = 1;
+	setsockopt(Native(this->handle), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+	SetNonBlocking(this->handle);
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef NET_SOCKET_H
+#define NET_SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+
+// UdpSocket sends and receives datagrams on the loopback interface without
+// ever blocking: it is polled once per frame by the game loop that owns it.
+class UdpSocket
+{
+public:
+	// constructor/destructor
+	UdpSocket();
+	~UdpSocket();
+	UdpSocket(const UdpSocket&) = delete;
+	UdpSocket& operator=(const UdpSocket&) = delete;
+	// binds to a port of 127.0.0.1 (0 picks a free one, see Port)
+	bool Open(uint16_t port);
+	void Close();
+	bool IsOpen() const;
+	uint16_t Port() const { return this->port; }
+	// sends a datagram to a port of 127.0.0.1
+	bool Send(uint16_t port, const void* data, size_t size);
+	// receives a pending datagram into data, returns its size or -1 if none is pending
+	int Receive(void* data, size_t size);
+private:
+	intptr_t	handle;
+	uint16_t	port;
+};
+
+// TcpSocket is a non-blocking stream socket on the loopback interface, either
+// listening for connections or connected. Sends and receives never wait: they
+// move what the socket buffers can take or hold right now.
+class TcpSocket
+{
+public:
+	// constructor/destructor
+	TcpSocket();
+	~TcpSocket();
+	TcpSocket(const TcpSocket&) = delete;
+	TcpSocket& operator=(const TcpSocket&) = delete;
+	TcpSocket(TcpSocket&& other) noexcept;
+	TcpSocket& operator=(TcpSocket&& other) noexcept;
+	// listens on a port of 127.0.0.1 (0 picks a free one, see Port)
+	bool Listen(uint16_t port);
+	// takes a pending connection of a listening socket, false if there is none
+	bool Accept(TcpSocket& client);
+	// connects to a port of 127.0.0.1
+	bool Connect(uint16_t port);
+	void Close();
+	bool IsOpen() const;
+	uint16_t Port() const { return this->port; }
+	// returns the bytes sent / received (0 if the socket can't take or has none right
+	// now) or -1 once the connection is gone
+	int Send(const void* data, size_t size);
+	int Receive(void* data, size_t size);
+private:
+	intptr_t	handle;
+	uint16_t	port;
+	void configure();
+};
+
+#endif
\ No newline at end of file
@@ -1,18 +1,20 @@
 #include "particle_generator.h"
 
-ParticleGenerator::ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount)
-    : shader(shader), texture(texture), amount(amount)
+ParticleGenerator::ParticleGenerator(unsigned int amount)
+    : amount(amount), lastUsedParticle(0)
 {
     this->init();
 }
 
-void ParticleGenerator::Update(float dt, GameObject& object, unsigned int newParticles, glm::vec2 offset)
+void ParticleGenerator::Update(float dt, GameObject& object, unsigned int newParticles, RandomStream& random, glm::vec2 offset)
 {
+    if (this->amount == 0)
+        return;
     // add new particles
     for (unsigned int i = 0; i < newParticles; ++i)
     {
         int unusedParticle = firstUnusedParticle();
-        this->respawnParticle(this->particles[unusedParticle], object, offset);
+        this->respawnParticle(this->particles[unusedParticle], object, random, offset);
     }
     // update all particles
     for (unsigned int i = 0; i < this->amount; ++i)
@@ -27,52 +29,13 @@ void ParticleGenerator::Update(float dt, GameObject& object, unsigned int newPar
     }
 }
 
-// render all particles
-void ParticleGenerator::Draw()
+const std::vector<Particle>& ParticleGenerator::GetParticles() const
 {
-    // use additive blending to give it a 'glow' effect
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    this->shader.Use();
-    for (Particle particle : this->particles)
-    {
-        if (particle.Life > 0.0f)
-        {
-            this->shader.setVec2("offset", particle.Position);
-            this->shader.setVec4("colour", particle.Colour);
-            this->texture.Bind();
-            glBindVertexArray(this->VAO);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            glBindVertexArray(0);
-        }
-    }
-    // default blending mode
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    return this->particles;
 }
 
 void ParticleGenerator::init()
 {
-    // set up mesh and attribute properties
-    unsigned int VBO;
-    float vertices[] =
-    {
-        0.0f, 1.0f, 0.0f, 1.0f,
-        1.0f, 0.0f, 1.0f, 0.0f,
-        0.0f, 0.0f, 0.0f, 0.0f,
-
-        0.0f, 1.0f, 0.0f, 1.0f,
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 0.0f, 1.0f, 0.0f
-    };
-    glGenVertexArrays(1, &this->VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(this->VAO);
-    // fill mesh buffer
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    // set mesh attributes
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glBindVertexArray(0);
     // create this->amount default particle instances
     for (unsigned int i = 0; i < this->amount; ++i)
     {
@@ -80,39 +43,37 @@ void ParticleGenerator::init()
     }
 }
 
-// stores the index of the last particle used (quick access to next dead particle)
-unsigned int lastUsedParticle = 0;
 unsigned int ParticleGenerator::firstUnusedParticle()
 {
     // search from last used particle, this will usually return almost instantly
-    for (unsigned int i = lastUsedParticle; i < this->amount; ++i)
+    for (unsigned int i = this->lastUsedParticle; i < this->amount; ++i)
     {
         if (this->particles[i].Life <= 0.0f)
         {
-            lastUsedParticle = i;
+            this->lastUsedParticle = i;
             return i;
         }
     }
     // otherwise, do a linear search
-    for (unsigned int i = 0; i < lastUsedParticle; ++i)
+    for (unsigned int i = 0; i < this->lastUsedParticle; ++i)
     {
         if (this->particles[i].Life <= 0.0f)
         {
-            lastUsedParticle = i;
+            this->lastUsedParticle = i;
             return i;
         }
     }
     // all particles are taken, override the first one
     // if it repeatedly hits this case, more particles should be reserved
-    lastUsedParticle = 0;
+    this->lastUsedParticle = 0;
     return 0;
 }
 
-void ParticleGenerator::respawnParticle(Particle& particle, GameObject& object, glm::vec2 offset)
+void ParticleGenerator::respawnParticle(Particle& particle, GameObject& object, RandomStream& random, glm::vec2 offset)
 {
-    float random = ((rand() % 100) - 50) / 10.0f;
-    float Colour = 0.5f + (rand() % 100) / 100.0f;
-    particle.Position = object.Position + random + offset;
+    float spread = (static_cast<int>(random.Below(100)) - 50) / 10.0f;
+    float Colour = 0.5f + random.Below(100) / 100.0f;
+    particle.Position = object.Position + spread + offset;
     particle.Colour = glm::vec4(Colour, Colour, Colour, 1.0f);
     particle.Life = 1.0f;
     particle.Velocity = object.Velocity * 0.1f;
@@ -1,14 +1,12 @@
 #ifndef PARTICLE_GENERATOR_H
 #define PARTICLE_GENERATOR_H
 
-#include <GLAD/glad/glad.h>
 #include <glm/glm.hpp>
 
 #include <vector>
 
-#include "shader.h"
-#include "texture.h"
 #include "game_object.h"
+#include "game_random.h"
 
 // Represents a single particle and its state
 struct Particle
@@ -20,32 +18,30 @@ struct Particle
 	Particle() : Position(0.0f), Velocity(0.0f), Colour(1.0f), Life(0.0f) { }
 };
 
-// ParticleGenerator acts as a container for rendering a large number of particles
+// ParticleGenerator acts as a container for a large number of particles
 // by repeatedly spawning and updating particles and killing them after a given
-// amount of time
+// amount of time. Rendering is done by the ParticleRenderer.
 class ParticleGenerator
 {
 public:
-	// constructor
-	ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount);
-	// update all particles
-	void Update(float dt, GameObject& object, unsigned int newParticles, glm::vec2 offset = glm::vec2(0.0f,0.0f));
-	// render all particles
-	void Draw();
+	// constructor (an amount of 0 disables the particles)
+	ParticleGenerator(unsigned int amount);
+	// update all particles, new particles are spread using random
+	void Update(float dt, GameObject& object, unsigned int newParticles, RandomStream& random, glm::vec2 offset = glm::vec2(0.0f,0.0f));
+	// retrieves all particles (alive or not) for rendering
+	const std::vector<Particle>& GetParticles() const;
 private:
 	// state
 	std::vector<Particle> particles;
 	unsigned int amount;
-	// render state
-	Shader shader;
-	Texture2D texture;
-	unsigned int VAO;
-	// initializes buffer and vertex attributes
+	// index of the last particle used (quick access to next dead particle)
+	unsigned int lastUsedParticle;
+	// initializes particle instances
 	void init();
 	// returns the first Particle index that's currently unused (Life <= 0.0f or 0 index)
 	unsigned int firstUnusedParticle();
 	// respanws particle
-	void respawnParticle(Particle& particle, GameObject& object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+	void respawnParticle(Particle& particle, GameObject& object, RandomStream& random, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
 };
 
 #endif
\ No newline at end of file
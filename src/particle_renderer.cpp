@@ -0,0 +1,60 @@
+#include "particle_renderer.h"
+
+ParticleRenderer::ParticleRenderer(Shader shader, Texture2D texture)
+    : shader(shader), texture(texture)
+{
+    this->initRenderData();
+}
+
+ParticleRenderer::~ParticleRenderer()
+{
+    glDeleteVertexArrays(1, &this->VAO);
+}
+
+// render all particles
+void ParticleRenderer::Draw(const std::vector<Particle>& particles)
+{
+    // use additive blending to give it a 'glow' effect
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    this->shader.Use();
+    for (const Particle& particle : particles)
+    {
+        if (particle.Life > 0.0f)
+        {
+            this->shader.setVec2("offset", particle.Position);
+            this->shader.setVec4("colour", particle.Colour);
+            this->texture.Bind();
+            glBindVertexArray(this->VAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            glBindVertexArray(0);
+        }
+    }
+    // default blending mode
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void ParticleRenderer::initRenderData()
+{
+    // set up mesh and attribute properties
+    unsigned int VBO;
+    float vertices[] =
+    {
+        0.0f, 1.0f, 0.0f, 1.0f,
+        1.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f,
+
+        0.0f, 1.0f, 0.0f, 1.0f,
+        1.0f, 1.0f, 1.0f, 1.0f,
+        1.0f, 0.0f, 1.0f, 0.0f
+    };
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(this->VAO);
+    // fill mesh buffer
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // set mesh attributes
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,32 @@
+#ifndef PARTICLE_RENDERER_H
+#define PARTICLE_RENDERER_H
+
+#include <GLAD/glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "shader.h"
+#include "texture.h"
+#include "particle_generator.h"
+
+// ParticleRenderer draws the particles simulated by a ParticleGenerator
+// as small textured quads using additive blending
+class ParticleRenderer
+{
+public:
+	// constructor/destructor
+	ParticleRenderer(Shader shader, Texture2D texture);
+	~ParticleRenderer();
+	// render all alive particles
+	void Draw(const std::vector<Particle>& particles);
+private:
+	// render state
+	Shader shader;
+	Texture2D texture;
+	unsigned int VAO;
+	// initializes buffer and vertex attributes
+	void initRenderData();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef PERCENTILE_H
+#define PERCENTILE_H
+
+#include <algorithm>
+#include <vector>
+
+// value at the given percentile of the (unsorted) samples, which are partially
+// reordered; 0 without samples
+inline double Percentile(std::vector<double>& samples, double percentile)
+{
+	if (samples.empty())
+		return 0.0;
+	size_t index = std::min(samples.size() - 1, static_cast<size_t>(percentile / 100.0 * samples.size()));
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+#endif
\ No newline at end of file
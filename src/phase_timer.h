@@ -0,0 +1,38 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <chrono>
+
+// time spent in the phases of a single Game::Update (seconds)
+struct PhaseTimes
+{
+	double Move, Streaming, Collisions, Events, Particles, PowerUps;
+};
+
+// PhaseTimer measures consecutive phases of a frame. When disabled it
+// never reads the clock, so instrumented code costs nothing by default.
+class PhaseTimer
+{
+public:
+	// constructor
+	PhaseTimer(bool enabled) : enabled(enabled)
+	{
+		if (enabled)
+			this->last = std::chrono::steady_clock::now();
+	}
+	// seconds since construction or the previous lap (0 when disabled)
+	double Lap()
+	{
+		if (!this->enabled)
+			return 0.0;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(now - this->last).count();
+		this->last = now;
+		return seconds;
+	}
+private:
+	bool enabled;
+	std::chrono::steady_clock::time_point last;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "power_up.h"
+#include "game.h"
+
+void ActivateSpeed(Game& game)
+{
+	game.Ball.Velocity *= 1.2f;
+}
+
+void ActivateSticky(Game& game)
+{
+	game.Ball.Sticky = true;
+	game.PlayerAppearance.Colour = glm::vec3(1.0f, 0.5f, 1.0f);
+}
+
+void DeactivateSticky(Game& game)
+{
+	game.Ball.Sticky = false;
+	game.PlayerAppearance.Colour = glm::vec3(1.0f);
+}
+
+void ActivatePassThrough(Game& game)
+{
+	game.Ball.PassThrough = true;
+	game.BallAppearance.Colour = glm::vec3(1.0f, 0.5f, 0.5f);
+}
+
+void DeactivatePassThrough(Game& game)
+{
+	game.Ball.PassThrough = false;
+	game.BallAppearance.Colour = glm::vec3(1.0f);
+}
+
+void ActivatePadSizeIncrease(Game& game)
+{
+	game.Player.Size.x += 100.0f;
+}
+
+void ActivateConfuse(Game& game)
+{
+	game.Effects.Chaos = false;
+	game.Effects.Confuse = true; // first - disable chaos, than confuse
+}
+
+void DeactivateConfuse(Game& game)
+{
+	game.Effects.Confuse = false;
+}
+
+void ActivateChaos(Game& game)
+{
+	game.Effects.Confuse = false;
+	game.Effects.Chaos = true; // first - disable confuse, than chaos
+}
+
+void DeactivateChaos(Game& game)
+{
+	game.Effects.Chaos = false;
+}
+
+const PowerUpKind POWERUP_KINDS[POWERUP_TYPE_COUNT] =
+{
+	// texture, spawn chance, duration, colour, activate, deactivate
+	{ "powerup_speed",       75,  0.0f, glm::vec3(0.5f, 0.5f, 1.0f),   ActivateSpeed,           nullptr },
+	{ "powerup_sticky",      75, 20.0f, glm::vec3(1.0f, 0.5f, 1.0f),   ActivateSticky,          DeactivateSticky },
+	{ "powerup_passthrough", 75, 10.0f, glm::vec3(0.5f, 1.0f, 0.5f),   ActivatePassThrough,     DeactivatePassThrough },
+	{ "powerup_increase",    75,  0.0f, glm::vec3(1.0f, 0.6f, 0.4f),   ActivatePadSizeIncrease, nullptr },
+	{ "powerup_confuse",     15, 15.0f, glm::vec3(1.0f, 0.3f, 0.3f),   ActivateConfuse,         DeactivateConfuse },
+	{ "powerup_chaos",       15, 15.0f, glm::vec3(0.9f, 0.25f, 0.25f), ActivateChaos,           DeactivateChaos }
+};
@@ -1,30 +1,57 @@
 #ifndef POWER_UP_H
 #define POWER_UP_H
 
-#include <string>
-
 #include <glm/glm.hpp>
-#include "game_object.h"
+
+class Game;
 
 // The size of a PowerUp block
 const glm::vec2 POWERUP_SIZE(120.f, 40.0f);
 // Velocity a PowerUp block has when spawned
 const glm::vec2 VELOCITY(0.0f, 300.0f);
 
-// PowerUp inherits its state and rendering functions from
-// GameObject but also holds extra information to state its
-// active duration and whether it is activated or not.
-// The type of PowerUp is stored as a string.
-class PowerUP : public GameObject
+// kinds of PowerUps, index into POWERUP_KINDS
+enum PowerUpType
+{
+	POWERUP_SPEED,
+	POWERUP_STICKY,
+	POWERUP_PASS_THROUGH,
+	POWERUP_PAD_SIZE_INCREASE,
+	POWERUP_CONFUSE,
+	POWERUP_CHAOS,
+	POWERUP_TYPE_COUNT
+};
+
+// static description of a kind of PowerUp
+struct PowerUpKind
+{
+	const char*	Texture;		// name of the texture in the ResourceManager
+	unsigned int SpawnChance;	// 1 in SpawnChance per destroyed brick
+	float		Duration;		// active time in seconds (0 = instant)
+	glm::vec3	Colour;
+	// applies the effect, called for every collected PowerUp
+	void		(*Activate)(Game& game);
+	// removes the effect once no PowerUp of this kind is active anymore (optional)
+	void		(*Deactivate)(Game& game);
+};
+
+// all kinds of PowerUps, indexed by PowerUpType (spawn rolls happen in this order)
+extern const PowerUpKind POWERUP_KINDS[POWERUP_TYPE_COUNT];
+
+// A falling PowerUp only carries its hot state; size, velocity and
+// colour are the same for every PowerUp of a kind, so they are read
+// from the constants and POWERUP_KINDS instead of being stored per
+// object. A PowerUp only exists while falling, once collected its
+// effect runs on a timer of the game.
+struct PowerUP
 {
-public:
 	// powerup state
-	std::string Type;
-	float		Duration;
-	bool		Activated;
+	glm::vec2	Position;
+	PowerUpType	Type;
+	bool		Destroyed;
 	// constructor
-	PowerUP(std::string type, glm::vec3 colour, float duration, glm::vec2 position, Texture2D texture)
-		: GameObject(position, POWERUP_SIZE, texture, colour, VELOCITY), Type(type), Duration(duration), Activated(false) {}
+	PowerUP(PowerUpType type, glm::vec2 position)
+		: Position(position), Type(type), Destroyed(false) {}
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "replay.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// FNV-1a over the bytes of padding-free values
+struct StateHash
+{
+	uint64_t Value = 14695981039346656037ull;
+	void Add(const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+			this->Value = (this->Value ^ bytes[i]) * 1099511628211ull;
+	}
+	template <typename T>
+	void Add(const T& value) { this->Add(&value, sizeof(value)); }
+	void Add(const GameObject& object)
+	{
+		this->Add(object.Position);
+		this->Add(object.Size);
+		this->Add(object.Velocity);
+		this->Add(object.Destroyed);
+	}
+};
+
+uint8_t ReadInput(const Game& game)
+{
+	uint8_t input = 0;
+	for (unsigned int i = 0; i < REPLAY_KEY_COUNT; ++i)
+		if (game.Keys[REPLAY_KEYS[i]])
+			input |= 1 << i;
+	return input;
+}
+
+void ApplyInput(Game& game, uint8_t input)
+{
+	for (unsigned int i = 0; i < REPLAY_KEY_COUNT; ++i)
+		game.Keys[REPLAY_KEYS[i]] = (input >> i) & 1;
+}
+
+uint64_t StateChecksum(const Game& game, std::vector<uint8_t>& scratch)
+{
+	StateHash hash;
+	hash.Add(game.Level);
+	hash.Add(game.State);
+	hash.Add(game.Lives);
+	hash.Add(game.Player);
+	hash.Add(static_cast<const GameObject&>(game.Ball));
+	hash.Add(game.Ball.Radius);
+	hash.Add(game.Ball.Stuck);
+	hash.Add(game.Ball.Sticky);
+	hash.Add(game.Ball.PassThrough);
+	hash.Add(game.Effects.Confuse);
+	hash.Add(game.Effects.Chaos);
+	hash.Add(game.Effects.Shake);
+	for (const PowerUP& powerUp : game.PowerUps)
+	{
+		hash.Add(powerUp.Position);
+		hash.Add(powerUp.Type);
+	}
+	hash.Add(game.ActivePowerUps);
+	RandomState random = game.Random.Save();
+	hash.Add(random.Seed);
+	hash.Add(random.Gameplay);
+	hash.Add(random.Visual);
+	hash.Add(game.Timers.Now);
+	for (const Timer& timer : game.Timers.Timers)
+	{
+		hash.Add(timer.Expiry);
+		hash.Add(timer.Id);
+		hash.Add(timer.Event);
+		hash.Add(timer.Payload);
+	}
+	// the brick state of the level: bitmap, tiles of the endless rows and chunk deltas
+	const GameLevel& level = game.Levels[game.Level];
+	scratch.resize(level.StateSize());
+	LevelSnapshot bricks = level.SaveState(scratch.data());
+	hash.Add(bricks.LiveBricks);
+	hash.Add(bricks.TopRow);
+	hash.Add(bricks.Top);
+	hash.Add(scratch.data(), scratch.size());
+	return hash.Value;
+}
+
+// appends value as a varint (7 bits per byte, low bits first)
+void WriteVarint(std::vector<uint8_t>& data, uint32_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		data.push_back(static_cast<uint8_t>(value | 0x80));
+	data.push_back(static_cast<uint8_t>(value));
+}
+
+void ReplayRecorder::Start(const Game& game, float timeStep)
+{
+	this->Header = { { 'B', 'R', 'P', 'L' }, REPLAY_VERSION, game.Random.GetSeed(), game.Level, game.Width, game.Height,
+		timeStep, 0, CHECKSUM_INTERVAL, 0, 0, 0, 0 };
+	game.Save(this->Snapshot);
+	this->Input.clear();
+	this->Checksums.clear();
+	this->input = 0;
+	this->lastChange = 0;
+}
+
+void ReplayRecorder::Record(const Game& game)
+{
+	uint8_t input = ReadInput(game);
+	if (input == this->input)
+		return;
+	WriteVarint(this->Input, this->Header.Frames - this->lastChange);
+	this->Input.push_back(input ^ this->input);
+	this->input = input;
+	this->lastChange = this->Header.Frames;
+}
+
+void ReplayRecorder::EndFrame(const Game& game)
+{
+	if (++this->Header.Frames % this->Header.ChecksumInterval == 0)
+		this->Checksums.push_back(StateChecksum(game, this->scratch));
+}
+
+bool ReplayRecorder::Save(const char* file, const Game& game)
+{
+	if (this->Header.Frames % this->Header.ChecksumInterval != 0)
+		this->Checksums.push_back(StateChecksum(game, this->scratch));
+	this->Header.SnapshotBytes = static_cast<uint32_t>(this->Snapshot.size());
+	StateHash snapshot;
+	snapshot.Add(this->Snapshot.data(), this->Snapshot.size());
+	this->Header.SnapshotChecksum = snapshot.Value;
+	this->Header.InputBytes = static_cast<uint32_t>(this->Input.size());
+	this->Header.Checksums = static_cast<uint32_t>(this->Checksums.size());
+	std::ofstream fstream(file, std::ios::binary);
+	fstream.write(reinterpret_cast<const char*>(&this->Header), sizeof(this->Header));
+	fstream.write(reinterpret_cast<const char*>(this->Snapshot.data()), this->Snapshot.size());
+	fstream.write(reinterpret_cast<const char*>(this->Input.data()), this->Input.size());
+	fstream.write(reinterpret_cast<const char*>(this->Checksums.data()), this->Checksums.size() * sizeof(uint64_t));
+	return static_cast<bool>(fstream);
+}
+
+ReplayPlayer::ReplayPlayer()
+	: Header(), Frame(0), DesyncFrame(-1), decoder()
+{
+}
+
+bool ReplayPlayer::Load(const char* file)
+{
+	std::ifstream fstream(file, std::ios::binary);
+	std::vector<char> data((std::istreambuf_iterator<char>(fstream)), std::istreambuf_iterator<char>());
+	if (data.size() < sizeof(ReplayHeader))
+	{
+		std::cout << "ERROR::REPLAY: Failed to read replay " << file << std::endl;
+		return false;
+	}
+	std::memcpy(&this->Header, data.data(), sizeof(ReplayHeader));
+	const ReplayHeader& header = this->Header;
+	uint64_t checksums = header.ChecksumInterval == 0 ? 0 : (static_cast<uint64_t>(header.Frames) + header.ChecksumInterval - 1) / header.ChecksumInterval;
+	if (std::memcmp(header.Magic, "BRPL", 4) != 0 || header.Version != REPLAY_VERSION || header.ChecksumInterval == 0
+		|| header.Checksums != checksums
+		|| data.size() != sizeof(ReplayHeader) + static_cast<uint64_t>(header.SnapshotBytes) + header.InputBytes + checksums * sizeof(uint64_t))
+	{
+		std::cout << "ERROR::REPLAY: Invalid replay " << file << std::endl;
+		return false;
+	}
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data()) + sizeof(ReplayHeader);
+	this->Snapshot.assign(bytes, bytes + header.SnapshotBytes);
+	bytes += header.SnapshotBytes;
+	// Start hands the snapshot to Game::Restore, a damaged one is not even tried
+	StateHash snapshot;
+	snapshot.Add(this->Snapshot.data(), this->Snapshot.size());
+	if (snapshot.Value != header.SnapshotChecksum)
+	{
+		std::cout << "ERROR::REPLAY: Damaged snapshot in replay " << file << std::endl;
+		return false;
+	}
+	this->Input.assign(bytes, bytes + header.InputBytes);
+	bytes += header.InputBytes;
+	this->Checksums.resize(header.Checksums);
+	std::memcpy(this->Checksums.data(), bytes, this->Checksums.size() * sizeof(uint64_t));
+	return true;
+}
+
+bool ReplayPlayer::Start(Game& game)
+{
+	if (game.Width != this->Header.Width || game.Height != this->Header.Height || !game.Restore(this->Snapshot))
+	{
+		std::cout << "ERROR::REPLAY: Replay does not fit the game (screen size or levels differ)" << std::endl;
+		return false;
+	}
+	this->Frame = 0;
+	this->DesyncFrame = -1;
+	this->decoder = {};
+	this->readChange();
+	this->keyframes.clear();
+	this->keyframe(game);
+	return true;
+}
+
+uint8_t ReplayPlayer::nextInput()
+{
+	while (this->Frame == this->decoder.NextChange)
+	{
+		this->decoder.Input ^= this->decoder.NextMask;
+		this->readChange();
+	}
+	return this->decoder.Input;
+}
+
+void ReplayPlayer::readChange()
+{
+	// no change after the last one (a truncated varint counts as the end as well)
+	uint32_t gap = 0;
+	for (unsigned int shift = 0; this->decoder.Position < this->Input.size() && shift < 32; shift += 7)
+	{
+		uint8_t byte = this->Input[this->decoder.Position++];
+		gap |= static_cast<uint32_t>(byte & 0x7f) << shift;
+		if (byte & 0x80)
+			continue;
+		if (this->decoder.Position < this->Input.size())
+		{
+			this->decoder.NextChange += gap;
+			this->decoder.NextMask = this->Input[this->decoder.Position++];
+			return;
+		}
+		break;
+	}
+	this->decoder.NextChange = UINT32_MAX;
+}
+
+void ReplayPlayer::keyframe(const Game& game)
+{
+	// keyframes are only taken the first time a frame is played
+	if (this->Frame / KEYFRAME_INTERVAL < this->keyframes.size())
+		return;
+	this->keyframes.push_back({ this->Frame, this->decoder, {} });
+	game.Save(this->keyframes.back().Snapshot);
+}
+
+void ReplayPlayer::verify(const Game& game)
+{
+	if (this->Frame > this->Header.Frames || (this->Frame % this->Header.ChecksumInterval != 0 && this->Frame != this->Header.Frames))
+		return;
+	uint64_t expected = this->Checksums[(this->Frame - 1) / this->Header.ChecksumInterval];
+	if (StateChecksum(game, this->scratch) != expected && (this->DesyncFrame < 0 || this->Frame < this->DesyncFrame))
+		this->DesyncFrame = this->Frame;
+}
\ No newline at end of file
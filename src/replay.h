@@ -0,0 +1,137 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+// header of a replay file (.rpl): followed by the snapshot the recording started
+// from (SnapshotBytes), the input changes (InputBytes, see ReplayRecorder) and
+// the state checksums (Checksums uint64 values, one every ChecksumInterval
+// frames and one after the last frame); fields are stored little endian. The
+// snapshot is checked against SnapshotChecksum (FNV-1a of its bytes) on load.
+struct ReplayHeader
+{
+	char		Magic[4];	// "BRPL"
+	uint32_t	Version;
+	uint64_t	Seed;		// seed of the recorded game (informational, the snapshot holds the random state)
+	uint32_t	Level;
+	uint32_t	Width, Height;
+	float		TimeStep;	// fixed step every frame was simulated with
+	uint32_t	Frames;
+	uint32_t	ChecksumInterval;
+	uint32_t	SnapshotBytes, InputBytes, Checksums;
+	uint64_t	SnapshotChecksum;
+};
+const uint32_t REPLAY_VERSION = 2;
+
+// keys Game::ProcessInput reads; bit i of an input mask is the state of REPLAY_KEYS[i]
+const int REPLAY_KEYS[] = { GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_SPACE, GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_LEFT_ALT };
+const unsigned int REPLAY_KEY_COUNT = sizeof(REPLAY_KEYS) / sizeof(REPLAY_KEYS[0]);
+// frames between the state checksums of a recording and between the keyframes of a playback
+const uint32_t CHECKSUM_INTERVAL = 600;
+const unsigned int KEYFRAME_INTERVAL = 600;
+
+// input mask of the keys held in the game / holds the keys of a mask
+uint8_t ReadInput(const Game& game);
+void ApplyInput(Game& game, uint8_t input);
+// hash of the simulation state of the game, field by field so padding and the
+// order of containers do not matter (scratch holds the level state)
+uint64_t StateChecksum(const Game& game, std::vector<uint8_t>& scratch);
+
+// ReplayRecorder records a game played with a fixed time step: the snapshot it
+// starts from, then per frame the keys it reads. Input is delta encoded, a frame
+// only costs bytes when the keys change: a varint with the frames since the
+// previous change followed by the mask of the keys that changed. Per frame call
+// Record once the keys are set and EndFrame once the frame is simulated.
+class ReplayRecorder
+{
+public:
+	ReplayHeader			Header;
+	std::vector<uint8_t>	Snapshot, Input;
+	std::vector<uint64_t>	Checksums;
+	// starts recording the game as it is now
+	void Start(const Game& game, float timeStep);
+	void Record(const Game& game);
+	void EndFrame(const Game& game);
+	// writes the replay (adding the checksum of the last frame)
+	bool Save(const char* file, const Game& game);
+private:
+	uint8_t					input;
+	uint32_t				lastChange;
+	std::vector<uint8_t>	scratch;
+};
+
+// ReplayPlayer re-simulates a recorded replay. A frame is simulated by the tick
+// given to Advance/Seek once the recorded keys are set (the same frame function
+// the recording ran), and the recorded checksums are compared as frames pass.
+// A keyframe snapshot is kept every KEYFRAME_INTERVAL frames, so seeking only
+// re-simulates from the nearest keyframe before the target.
+class ReplayPlayer
+{
+public:
+	ReplayHeader			Header;
+	std::vector<uint8_t>	Snapshot, Input;
+	std::vector<uint64_t>	Checksums;
+	// frames played, and the first frame whose checksum did not match (-1 while in sync)
+	uint32_t				Frame;
+	int64_t					DesyncFrame;
+	// constructor
+	ReplayPlayer();
+	// reads a replay file
+	bool Load(const char* file);
+	// puts the game (set up with the same screen size and levels) at the start of the replay
+	bool Start(Game& game);
+	bool Done() const { return this->Frame >= this->Header.Frames; }
+	// plays the next frame
+	template <typename Tick>
+	void Advance(Game& game, Tick tick)
+	{
+		if (this->Frame % KEYFRAME_INTERVAL == 0)
+			this->keyframe(game);
+		ApplyInput(game, this->nextInput());
+		tick(game);
+		++this->Frame;
+		this->verify(game);
+	}
+	// continues from the keyframe or frame closest before the given frame up to it
+	template <typename Tick>
+	void Seek(Game& game, uint32_t frame, Tick tick)
+	{
+		frame = std::min(frame, this->Header.Frames);
+		const Keyframe& key = this->keyframes[std::min<size_t>(frame / KEYFRAME_INTERVAL, this->keyframes.size() - 1)];
+		if (this->Frame > frame || key.Frame > this->Frame)
+		{
+			game.Restore(key.Snapshot);
+			this->Frame = key.Frame;
+			this->decoder = key.Stream;
+		}
+		while (this->Frame < frame)
+			this->Advance(game, tick);
+	}
+private:
+	// position in the input stream: the next change and the keys held
+	struct Decoder
+	{
+		size_t		Position;
+		uint32_t	NextChange;
+		uint8_t		NextMask, Input;
+	};
+	struct Keyframe
+	{
+		uint32_t				Frame;
+		Decoder					Stream;
+		std::vector<uint8_t>	Snapshot;
+	};
+	Decoder					decoder;
+	std::vector<Keyframe>	keyframes;
+	std::vector<uint8_t>	scratch;
+	uint8_t nextInput();
+	void readChange();
+	void keyframe(const Game& game);
+	void verify(const Game& game);
+};
+
+#endif
\ No newline at end of file
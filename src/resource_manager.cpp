@@ -8,13 +8,33 @@
 // Instantiate static variables
 std::map<std::string, Texture2D>	ResourceManager::Textures;
 std::map<std::string, Shader>		ResourceManager::Shaders;
+std::map<std::string, ShaderFiles>	ResourceManager::ShaderSources;
 
 Shader& ResourceManager::LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name)
 {
 	Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
+	ShaderSources[name] = { vShaderFile, fShaderFile, gShaderFile != nullptr ? gShaderFile : "" };
 	return Shaders[name];
 }
 
+unsigned int ResourceManager::ReloadShader(const std::string& file)
+{
+	unsigned int reloaded = 0;
+	for (auto& iter : ShaderSources)
+	{
+		const ShaderFiles& files = iter.second;
+		if (file != files.Vertex && file != files.Fragment && file != files.Geometry)
+			continue;
+		std::string vertexCode = readFile(files.Vertex);
+		std::string fragmentCode = readFile(files.Fragment);
+		std::string geometryCode = files.Geometry.empty() ? "" : readFile(files.Geometry);
+		if (Shaders[iter.first].Recompile(vertexCode.c_str(), fragmentCode.c_str(),
+			files.Geometry.empty() ? nullptr : geometryCode.c_str()))
+			++reloaded;
+	}
+	return reloaded;
+}
+
 Shader& ResourceManager::GetShader(std::string name)
 {
 	return  Shaders[name];
@@ -85,6 +105,14 @@ Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char*
 	return shader;
 }
 
+std::string ResourceManager::readFile(const std::string& file)
+{
+	std::ifstream stream(file);
+	std::stringstream contents;
+	contents << stream.rdbuf();
+	return contents.str();
+}
+
 Texture2D ResourceManager::loadTextureFromFile(const char* file, bool alpha)
 {
 	// create texture object
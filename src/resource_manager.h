@@ -6,16 +6,26 @@
 #include "texture.h"
 #include "shader.h"
 
+// source files a shader program was built from (geometry is optional)
+struct ShaderFiles
+{
+	std::string Vertex, Fragment, Geometry;
+};
+
 class ResourceManager
 {
 public:
 	// resource storage
 	static std::map<std::string, Shader>	Shaders;
+	static std::map<std::string, ShaderFiles> ShaderSources;
 	static std::map<std::string, Texture2D> Textures;
 	// loads (and generates) a shader program from file loading vertex, fragment (and geometry)
 	static Shader&	 LoadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name);
 	// retrieves a stored shader
 	static Shader&	 GetShader(std::string name);
+	// rebuilds (in place) every shader program that uses the given source file,
+	// returns the number of programs rebuilt
+	static unsigned int ReloadShader(const std::string& file);
 	// loads (and generates) a texture from file
 	static Texture2D& LoadTexture(const char* file, bool alpha, std::string name);
 	// retrieves a stored texture
@@ -28,6 +38,8 @@ private:
 	ResourceManager() { }
 	// loads and generates a shader from file
 	static Shader	loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile = nullptr);
+	// reads a whole text file
+	static std::string readFile(const std::string& file);
 	// loads a single texture from file
 	static Texture2D loadTextureFromFile(const char* file, bool alpha);
 };
@@ -0,0 +1,46 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <type_traits>
+
+// RingBuffer is a fixed capacity FIFO stored inline, without any allocation.
+// Items are pushed at the back and consumed from the front; the read and
+// write counters only ever grow and wrap around the power of two capacity.
+// Items must be trivially copyable, so the buffer can be copied as plain memory.
+template <typename T, unsigned int Capacity>
+class RingBuffer
+{
+	static_assert(std::is_trivially_copyable<T>::value, "RingBuffer items must be trivially copyable");
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "RingBuffer capacity must be a power of two");
+public:
+	// constructor
+	RingBuffer() : head(0), tail(0) { }
+	// number of items
+	unsigned int Size() const { return this->tail - this->head; }
+	bool Empty() const { return this->head == this->tail; }
+	bool Full() const { return this->Size() == Capacity; }
+	// whether the counters are consistent (a buffer copied in from outside could hold anything)
+	bool Valid() const { return this->Size() <= Capacity; }
+	// item at a position counted from the front
+	T& operator[](unsigned int index) { return this->items[(this->head + index) & (Capacity - 1)]; }
+	const T& operator[](unsigned int index) const { return this->items[(this->head + index) & (Capacity - 1)]; }
+	// appends an item, returns false (dropping nothing) when the buffer is full
+	bool Push(const T& item)
+	{
+		if (this->Full())
+			return false;
+		this->items[this->tail++ & (Capacity - 1)] = item;
+		return true;
+	}
+	// oldest item
+	T& Front() { return this->items[this->head & (Capacity - 1)]; }
+	// removes the oldest item
+	void Pop() { ++this->head; }
+	// removes all items
+	void Clear() { this->head = this->tail; }
+private:
+	T				items[Capacity];
+	unsigned int	head, tail;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "rollback_session.h"
+#include "replay.h"
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+
+// bytes of a datagram carrying count inputs
+size_t PacketSize(unsigned int count)
+{
+	return offsetof(InputPacket, Inputs) + count;
+}
+
+RollbackSession::RollbackSession(Game& board0, Game& board1, unsigned int localPlayer, UdpSocket& socket, uint16_t remotePort, uint64_t seed)
+	: Boards{ &board0, &board1 }, LocalPlayer(localPlayer), Shim{ 0.0, 0.0, 0.0f }, Frame(0), RemoteFrame(0), AckedFrame(0),
+	Rollbacks(0), ResimulatedFrames(0), MaxRollback(0), Stalls(0), Sent(0), Dropped(0), Received(0), SyncChecks(0), DesyncFrame(-1),
+	socket(socket), remotePort(remotePort), random(seed), states(), inputs(), rollbackFrame(UINT32_MAX),
+	syncPoints(), nextSync(SYNC_INTERVAL), comparedSync(0), remoteSync{ 0, 0 }
+{
+}
+
+void RollbackSession::Poll(double now)
+{
+	// the shim's held back datagrams that are due (in the order they fall due)
+	std::sort(this->delayed.begin(), this->delayed.end(), [](const Delayed& a, const Delayed& b) { return a.Due < b.Due; });
+	size_t due = 0;
+	for (; due < this->delayed.size() && this->delayed[due].Due <= now; ++due)
+		this->socket.Send(this->remotePort, &this->delayed[due].Packet, PacketSize(this->delayed[due].Packet.Count));
+	this->delayed.erase(this->delayed.begin(), this->delayed.begin() + due);
+
+	InputPacket packet;
+	int size;
+	while ((size = this->socket.Receive(&packet, sizeof(packet))) >= 0)
+		if (static_cast<size_t>(size) >= PacketSize(0) && packet.Count <= INPUT_RING && static_cast<size_t>(size) == PacketSize(packet.Count))
+			this->receive(packet);
+}
+
+void RollbackSession::receive(const InputPacket& packet)
+{
+	++this->Received;
+	this->AckedFrame = std::max(this->AckedFrame, std::min(packet.Ack, this->Frame));
+	unsigned int remote = 1 - this->LocalPlayer;
+	// only the inputs right after the confirmed ones are taken, older ones are repeats
+	for (uint32_t i = 0; i < packet.Count; ++i)
+	{
+		uint32_t frame = packet.Start + i;
+		if (frame < this->RemoteFrame)
+			continue;
+		if (frame > this->RemoteFrame)
+			break;
+		uint8_t& input = this->inputs[frame % INPUT_RING][remote];
+		// a played frame whose prediction was wrong has to be played again
+		if (frame < this->Frame && input != packet.Inputs[i])
+			this->rollbackFrame = std::min(this->rollbackFrame, frame);
+		input = packet.Inputs[i];
+		++this->RemoteFrame;
+	}
+	if (packet.SyncFrame > this->remoteSync.Frame)
+	{
+		this->remoteSync = { packet.SyncFrame, packet.Checksum };
+		this->compareSync();
+	}
+}
+
+bool RollbackSession::Advance(uint8_t input)
+{
+	this->rollback();
+	this->confirmSyncFrames();
+	if (this->Frame >= this->RemoteFrame + MAX_ROLLBACK_FRAMES)
+	{
+		++this->Stalls;
+		return false;
+	}
+	this->inputs[this->Frame % INPUT_RING][this->LocalPlayer] = input;
+	this->simulate(this->Frame++);
+	return true;
+}
+
+void RollbackSession::Send(double now)
+{
+	InputPacket packet;
+	packet.Start = this->AckedFrame;
+	packet.Count = static_cast<uint8_t>(std::min(this->Frame - this->AckedFrame, INPUT_RING));
+	for (uint32_t i = 0; i < packet.Count; ++i)
+		packet.Inputs[i] = this->inputs[(packet.Start + i) % INPUT_RING][this->LocalPlayer];
+	packet.Ack = this->RemoteFrame;
+	const SyncPoint& sync = this->syncPoints[(this->nextSync / SYNC_INTERVAL + this->syncPoints.size() - 1) % this->syncPoints.size()];
+	packet.SyncFrame = sync.Frame;
+	packet.Checksum = sync.Checksum;
+	++this->Sent;
+	if (this->random.Float() < this->Shim.Loss)
+	{
+		++this->Dropped;
+		return;
+	}
+	double delay = this->Shim.Latency + this->Shim.Jitter * this->random.Float();
+	if (delay <= 0.0)
+		this->socket.Send(this->remotePort, &packet, PacketSize(packet.Count));
+	else
+		this->delayed.push_back({ now + delay, packet });
+}
+
+bool RollbackSession::Synchronize()
+{
+	this->rollback();
+	this->confirmSyncFrames();
+	return this->RemoteFrame >= this->Frame;
+}
+
+uint64_t RollbackSession::Checksum()
+{
+	return StateChecksum(*this->Boards[0], this->scratch) * 31 + StateChecksum(*this->Boards[1], this->scratch);
+}
+
+void RollbackSession::rollback()
+{
+	if (this->rollbackFrame >= this->Frame)
+		return;
+	unsigned int depth = this->Frame - this->rollbackFrame;
+	++this->Rollbacks;
+	this->ResimulatedFrames += depth;
+	this->MaxRollback = std::max(this->MaxRollback, depth);
+	const FrameState& state = this->states[this->rollbackFrame % this->states.size()];
+	for (unsigned int player = 0; player < 2; ++player)
+		this->Boards[player]->Restore(state.Snapshots[player]);
+	for (uint32_t frame = this->rollbackFrame; frame < this->Frame; ++frame)
+		this->simulate(frame);
+	this->rollbackFrame = UINT32_MAX;
+}
+
+void RollbackSession::confirmSyncFrames()
+{
+	// a sync frame's state is final once the inputs of all frames before it are confirmed
+	for (; this->nextSync < this->Frame && this->nextSync <= this->RemoteFrame; this->nextSync += SYNC_INTERVAL)
+	{
+		this->syncPoints[this->nextSync / SYNC_INTERVAL % this->syncPoints.size()] =
+			{ this->nextSync, this->states[this->nextSync % this->states.size()].Checksum };
+		this->compareSync();
+	}
+}
+
+void RollbackSession::compareSync()
+{
+	uint32_t frame = this->remoteSync.Frame;
+	const SyncPoint& local = this->syncPoints[frame / SYNC_INTERVAL % this->syncPoints.size()];
+	if (frame == 0 || frame <= this->comparedSync || local.Frame != frame)
+		return;
+	this->comparedSync = frame;
+	++this->SyncChecks;
+	if (local.Checksum != this->remoteSync.Checksum && this->DesyncFrame < 0)
+		this->DesyncFrame = frame;
+}
+
+void RollbackSession::simulate(uint32_t frame)
+{
+	FrameState& state = this->states[frame % this->states.size()];
+	for (unsigned int player = 0; player < 2; ++player)
+		this->Boards[player]->Save(state.Snapshots[player]);
+	if (frame % SYNC_INTERVAL == 0)
+		state.Checksum = this->Checksum();
+	// the remote input is predicted to stay what it was last
+	unsigned int remote = 1 - this->LocalPlayer;
+	if (frame >= this->RemoteFrame)
+		this->inputs[frame % INPUT_RING][remote] = this->RemoteFrame > 0 ? this->inputs[(this->RemoteFrame - 1) % INPUT_RING][remote] : 0;
+	for (unsigned int player = 0; player < 2; ++player)
+	{
+		ApplyInput(*this->Boards[player], this->inputs[frame % INPUT_RING][player]);
+		this->Tick(*this->Boards[player]);
+	}
+}
\ No newline at end of file
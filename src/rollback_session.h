@@ -0,0 +1,117 @@
+#ifndef ROLLBACK_SESSION_H
+#define ROLLBACK_SESSION_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "game.h"
+#include "game_random.h"
+#include "net_socket.h"
+
+// frames a session may run ahead of the last confirmed remote input
+const unsigned int MAX_ROLLBACK_FRAMES = 8;
+// local inputs kept for resending (covers the frames the peer can be missing)
+const unsigned int INPUT_RING = 32;
+// frames between the state checksums the peers compare
+const unsigned int SYNC_INTERVAL = 60;
+
+// datagram of a versus peer: its inputs from Start on (resent until acknowledged,
+// so a lost datagram needs no retransmission), the first frame of the receiver's
+// inputs it is missing and the checksum of its latest confirmed sync frame
+struct InputPacket
+{
+	uint64_t	Checksum;
+	uint32_t	SyncFrame;	// 0: no sync frame confirmed yet
+	uint32_t	Ack;
+	uint32_t	Start;
+	uint8_t		Count;
+	uint8_t		Inputs[INPUT_RING];
+};
+
+// artificial latency and loss applied to the datagrams a session sends
+struct LinkShim
+{
+	double	Latency;	// seconds a datagram is held back
+	double	Jitter;		// random extra delay up to this many seconds (reorders datagrams)
+	float	Loss;		// share of the datagrams dropped
+};
+
+// RollbackSession plays a two-player versus match (two boards side by side, one
+// per player) over UDP the way GGPO does: the local input is applied right away
+// and the remote one is predicted (the last one confirmed is repeated). When a
+// remote input arrives that differs from its prediction, the boards are restored
+// to the state before that frame and re-simulated up to the present, so the
+// boards never wait for the network unless the remote input is more than
+// MAX_ROLLBACK_FRAMES behind. A board's frame is Tick after its keys are set.
+class RollbackSession
+{
+public:
+	// the boards of player 0 and 1, LocalPlayer's input is given to Advance
+	std::array<Game*, 2>		Boards;
+	unsigned int				LocalPlayer;
+	std::function<void(Game&)>	Tick;
+	LinkShim					Shim;
+	// next frame to simulate, the remote inputs are confirmed for the frames before
+	// RemoteFrame and the peer has the local inputs of the frames before AckedFrame
+	uint32_t					Frame, RemoteFrame, AckedFrame;
+	// statistics: rollbacks (and the frames they re-simulated), frames that had to
+	// wait for the remote input, datagrams and sync frames compared
+	unsigned int				Rollbacks, ResimulatedFrames, MaxRollback, Stalls;
+	unsigned int				Sent, Dropped, Received, SyncChecks;
+	int64_t						DesyncFrame;	// first sync frame whose checksums differed, -1 if none
+	// constructor (seed drives the shim's loss and jitter)
+	RollbackSession(Game& board0, Game& board1, unsigned int localPlayer, UdpSocket& socket, uint16_t remotePort, uint64_t seed);
+	// hands the held back datagrams that are due to the socket and reads the remote inputs
+	void Poll(double now);
+	// plays the next frame with the given local input; false (and nothing played)
+	// while the remote input is too far behind
+	bool Advance(uint8_t input);
+	// sends the local inputs the peer has not acknowledged yet
+	void Send(double now);
+	// re-simulates mispredicted frames, true once the boards hold the confirmed state
+	// of all frames played
+	bool Synchronize();
+	// checksum of both boards
+	uint64_t Checksum();
+private:
+	// a datagram held back by the shim
+	struct Delayed
+	{
+		double			Due;
+		InputPacket		Packet;
+	};
+	// boards at the start of a frame, and their checksum on sync frames
+	struct FrameState
+	{
+		std::vector<uint8_t>	Snapshots[2];
+		uint64_t				Checksum;
+	};
+	UdpSocket&				socket;
+	uint16_t				remotePort;
+	RandomStream			random;
+	std::vector<Delayed>	delayed;
+	std::array<FrameState, MAX_ROLLBACK_FRAMES + 1> states;
+	uint8_t					inputs[INPUT_RING][2];
+	// earliest mispredicted frame (UINT32_MAX if none)
+	uint32_t				rollbackFrame;
+	// checksums of the latest confirmed sync frames, the next one to confirm, the
+	// peer's latest and the latest compared
+	struct SyncPoint
+	{
+		uint32_t	Frame;
+		uint64_t	Checksum;
+	};
+	std::array<SyncPoint, 8> syncPoints;
+	uint32_t				nextSync, comparedSync;
+	SyncPoint				remoteSync;
+	std::vector<uint8_t>	scratch;
+	void receive(const InputPacket& packet);
+	void rollback();
+	void confirmSyncFrames();
+	void compareSync();
+	void simulate(uint32_t frame);
+};
+
+#endif
\ No newline at end of file
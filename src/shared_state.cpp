@@ -0,0 +1,292 @@
+#include "shared_state.h"
+#include "replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// tries of a reader before it gives up on a frame the game keeps rewriting
+const unsigned int READ_TRIES = 1000;
+
+#ifdef _WIN32
+
+// named file mappings of a session live in the Local\ namespace
+std::string SegmentName(const char* name)
+{
+	return std::string("Local\\") + name;
+}
+
+SharedMemory::SharedMemory()
+	: data(nullptr), size(0), owner(false), mapping(nullptr)
+{
+}
+
+bool SharedMemory::Create(const char* name, size_t size)
+{
+	this->Close();
+	// mappings backed by the paging file start out zeroed and go away with their last handle
+	this->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32), static_cast<DWORD>(size), SegmentName(name).c_str());
+	if (this->mapping)
+		this->data = MapViewOfFile(this->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!this->data)
+	{
+		this->Close();
+		return false;
+	}
+	this->size = size;
+	this->owner = true;
+	return true;
+}
+
+bool SharedMemory::Open(const char* name, size_t size)
+{
+	this->Close();
+	this->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, SegmentName(name).c_str());
+	if (this->mapping)
+		this->data = MapViewOfFile(this->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!this->data)
+	{
+		this->Close();
+		return false;
+	}
+	this->size = size;
+	return true;
+}
+
+void SharedMemory::Close()
+{
+	if (this->data)
+		UnmapViewOfFile(this->data);
+	if (this->mapping)
+		CloseHandle(this->mapping);
+	this->data = nullptr;
+	this->size = 0;
+	this->mapping = nullptr;
+	this->owner = false;
+}
+
+#else
+
+// POSIX shared memory names start with a slash
+std::string SegmentName(const char* name)
+{
+	return name[0] == '/' ? std::string(name) : std::string("/") + name;
+}
+
+SharedMemory::SharedMemory()
+	: data(nullptr), size(0), owner(false)
+{
+}
+
+bool SharedMemory::Create(const char* name, size_t size)
+{
+	this->Close();
+	this->name = SegmentName(name);
+	shm_unlink(this->name.c_str());
+	int fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0)
+		return false;
+	// a new segment is zero filled up to its size
+	void* data = ftruncate(fd, static_cast<off_t>(size)) == 0
+		? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		shm_unlink(this->name.c_str());
+		return false;
+	}
+	this->data = data;
+	this->size = size;
+	this->owner = true;
+	return true;
+}
+
+bool SharedMemory::Open(const char* name, size_t size)
+{
+	this->Close();
+	int fd = shm_open(SegmentName(name).c_str(), O_RDWR, 0);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	void* data = fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= size
+		? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	// the mapping stays valid after closing the descriptor
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+	this->data = data;
+	this->size = size;
+	return true;
+}
+
+void SharedMemory::Close()
+{
+	if (this->data)
+		munmap(this->data, this->size);
+	// processes that still map the segment keep it until they unmap it
+	if (this->owner)
+		shm_unlink(this->name.c_str());
+	this->data = nullptr;
+	this->size = 0;
+	this->owner = false;
+}
+
+#endif
+
+SharedMemory::~SharedMemory()
+{
+	this->Close();
+}
+
+int64_t SharedClock()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SharedStateExport::SharedStateExport()
+	: AgentInputs(0), RoundTrip(0.0), MaxRoundTrip(0.0), segment(nullptr), inputSequence(0), keys(0), publishedAt(0)
+{
+}
+
+SharedStateExport::~SharedStateExport()
+{
+	this->Close();
+}
+
+bool SharedStateExport::Open(const char* name)
+{
+	this->Close();
+	if (!this->memory.Create(name, sizeof(SharedStateSegment)))
+		return false;
+	this->segment = new (this->memory.Data()) SharedStateSegment();
+	std::memcpy(this->segment->Magic, SHARED_STATE_MAGIC, sizeof(SHARED_STATE_MAGIC));
+	this->segment->Version = SHARED_STATE_VERSION;
+	this->segment->Size = sizeof(SharedStateSegment);
+	this->segment->Live.store(1, std::memory_order_release);
+	this->inputSequence = 0;
+	return true;
+}
+
+void SharedStateExport::Close()
+{
+	if (this->segment)
+		this->segment->Live.store(0, std::memory_order_release);
+	this->segment = nullptr;
+	this->memory.Close();
+}
+
+void SharedStateExport::Publish(const Game& game, uint32_t frame)
+{
+	SharedStateSegment& segment = *this->segment;
+	uint32_t sequence = segment.Sequence.load(std::memory_order_relaxed);
+	segment.Sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	segment.Frame.Frame = frame;
+	segment.Frame.WorldSize = game.WorldSize();
+	CaptureSpectatorState(game, segment.Frame.State);
+	segment.Frame.PublishedAt = this->publishedAt = SharedClock();
+	segment.Sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool SharedStateExport::ReadAgentInput(Game& game)
+{
+	SharedStateSegment& segment = *this->segment;
+	// a new input is taken once it is complete, a torn one is taken next frame
+	uint32_t sequence = segment.InputSequence.load(std::memory_order_acquire);
+	if (sequence != this->inputSequence && sequence % 2 == 0)
+	{
+		uint32_t keys = segment.Keys.load(std::memory_order_relaxed);
+		int64_t writtenAt = segment.WrittenAt.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (segment.InputSequence.load(std::memory_order_relaxed) == sequence)
+		{
+			this->inputSequence = sequence;
+			this->keys = static_cast<uint8_t>(keys);
+			double roundTrip = std::max<int64_t>(writtenAt - this->publishedAt, 0) * 1e-9;
+			++this->AgentInputs;
+			this->RoundTrip += roundTrip;
+			this->MaxRoundTrip = std::max(this->MaxRoundTrip, roundTrip);
+		}
+	}
+	if (this->inputSequence == 0)
+		return false;
+	ApplyInput(game, this->keys);
+	return true;
+}
+
+SharedStateReader::SharedStateReader()
+	: Retries(0), segment(nullptr)
+{
+}
+
+bool SharedStateReader::Open(const char* name)
+{
+	this->Close();
+	if (!this->memory.Open(name, sizeof(SharedStateSegment)))
+		return false;
+	// the header is complete once Live is set
+	SharedStateSegment* segment = static_cast<SharedStateSegment*>(this->memory.Data());
+	if (segment->Live.load(std::memory_order_acquire) == 0
+		|| std::memcmp(segment->Magic, SHARED_STATE_MAGIC, sizeof(SHARED_STATE_MAGIC)) != 0
+		|| segment->Version != SHARED_STATE_VERSION || segment->Size != sizeof(SharedStateSegment))
+	{
+		this->memory.Close();
+		return false;
+	}
+	this->segment = segment;
+	return true;
+}
+
+void SharedStateReader::Close()
+{
+	this->segment = nullptr;
+	this->memory.Close();
+}
+
+bool SharedStateReader::Live() const
+{
+	return this->segment && this->segment->Live.load(std::memory_order_acquire) != 0;
+}
+
+bool SharedStateReader::Read(SharedFrame& frame)
+{
+	SharedStateSegment& segment = *this->segment;
+	for (unsigned int i = 0; i < READ_TRIES; ++i)
+	{
+		uint32_t sequence = segment.Sequence.load(std::memory_order_acquire);
+		if (sequence == 0)
+			return false;
+		if (sequence % 2 == 0)
+		{
+			std::memcpy(&frame, &segment.Frame, sizeof(frame));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (segment.Sequence.load(std::memory_order_relaxed) == sequence)
+				return true;
+		}
+		++this->Retries;
+	}
+	return false;
+}
+
+void SharedStateReader::WriteInput(uint8_t keys)
+{
+	SharedStateSegment& segment = *this->segment;
+	uint32_t sequence = segment.InputSequence.load(std::memory_order_relaxed);
+	segment.InputSequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	segment.Keys.store(keys, std::memory_order_relaxed);
+	segment.WrittenAt.store(SharedClock(), std::memory_order_relaxed);
+	segment.InputSequence.store(sequence + 2, std::memory_order_release);
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef SHARED_STATE_H
+#define SHARED_STATE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "game.h"
+#include "spectator_stream.h"
+
+// SharedMemory maps a named shared memory segment (POSIX shm, a named file
+// mapping on Windows) read-write, so several processes see the same pages.
+// The mapping lives as long as the object.
+class SharedMemory
+{
+public:
+	// constructor/destructor
+	SharedMemory();
+	~SharedMemory();
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+	// creates a zeroed segment of size bytes, replacing one a crashed process left behind
+	bool Create(const char* name, size_t size);
+	// maps an existing segment, false if there is none or it is smaller than size
+	bool Open(const char* name, size_t size);
+	// unmaps the segment, and removes its name if it was created here
+	void Close();
+	void* Data() const { return this->data; }
+	size_t Size() const { return this->size; }
+private:
+	void*		data;
+	size_t		size;
+	std::string	name;
+	bool		owner;
+#ifdef _WIN32
+	void*		mapping;
+#endif
+};
+
+// layout of the segment, the version changes with every change to SharedStateSegment
+const char SHARED_STATE_MAGIC[4] = { 'B', 'S', 'H', 'M' };
+const uint32_t SHARED_STATE_VERSION = 2;
+
+// a frame of the game as readers copy it
+struct SharedFrame
+{
+	uint32_t		Frame;
+	uint32_t		Reserved;
+	glm::vec2		WorldSize;
+	int64_t			PublishedAt;	// steady clock in nanoseconds (the same clock in every process)
+	SpectatorState	State;
+};
+
+// fixed layout of the segment: a header, the published frame and the input of an
+// agent. Both directions are seqlocks (the sequence is odd while its writer writes
+// and a reader that saw it change copied a torn value and tries again), so neither
+// side ever waits for the other. State and input are on separate cache lines.
+struct SharedStateSegment
+{
+	// written by the game before Live is set
+	char					Magic[4];
+	uint32_t				Version;
+	uint32_t				Size;	// sizeof(SharedStateSegment)
+	std::atomic<uint32_t>	Live;	// 1 while the game publishes frames
+	// game -> readers
+	alignas(64) std::atomic<uint32_t>	Sequence;
+	SharedFrame				Frame;
+	// agent -> game (one agent writes it), InputSequence stays 0 until it wrote keys
+	alignas(64) std::atomic<uint32_t>	InputSequence;
+	std::atomic<uint32_t>	Keys;		// mask of REPLAY_KEYS
+	std::atomic<int64_t>	WrittenAt;	// steady clock in nanoseconds
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free,
+	"atomics in shared memory must be lock free");
+
+// steady clock in nanoseconds
+int64_t SharedClock();
+
+// SharedStateExport is the game's side of the segment: it publishes the state of
+// each frame in place (captured straight into the segment, no copies or system
+// calls) and takes the keys an external agent wrote.
+class SharedStateExport
+{
+public:
+	// statistics: inputs taken from the agent, and the summed / largest round trip from
+	// publishing a frame to the agent writing its input for it (seconds)
+	unsigned int	AgentInputs;
+	double			RoundTrip, MaxRoundTrip;
+	// constructor/destructor
+	SharedStateExport();
+	~SharedStateExport();
+	// creates the segment under the name
+	bool Open(const char* name);
+	// tells the readers the game is gone and removes the segment
+	void Close();
+	bool IsOpen() const { return this->segment != nullptr; }
+	// game thread: publishes the state at the end of a frame
+	void Publish(const Game& game, uint32_t frame);
+	// game thread: sets the keys the agent wrote last; false (keys untouched) as long
+	// as no agent wrote any
+	bool ReadAgentInput(Game& game);
+private:
+	SharedMemory		memory;
+	SharedStateSegment*	segment;
+	uint32_t			inputSequence;
+	uint8_t				keys;
+	int64_t				publishedAt;
+};
+
+// SharedStateReader is an external process' side of the segment.
+class SharedStateReader
+{
+public:
+	// copies retried because the game was writing the frame
+	unsigned long long	Retries;
+	// constructor
+	SharedStateReader();
+	// maps the segment of a running game, false if there is none or its layout differs
+	bool Open(const char* name);
+	void Close();
+	// false once the game closed the export
+	bool Live() const;
+	// copies the last published frame; false if there is none yet or no copy was
+	// consistent within a bounded number of tries
+	bool Read(SharedFrame& frame);
+	// writes the keys (mask of REPLAY_KEYS) the game takes at its next frame
+	void WriteInput(uint8_t keys);
+private:
+	SharedMemory		memory;
+	SharedStateSegment*	segment;
+};
+
+#endif
\ No newline at end of file
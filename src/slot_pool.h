@@ -0,0 +1,150 @@
+#ifndef SLOT_POOL_H
+#define SLOT_POOL_H
+
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// handle to an element of a SlotPool: the slot plus the generation of the slot
+// the element was created in. A handle to a removed element never becomes valid
+// again, even after its slot was reused.
+struct PoolHandle
+{
+	uint32_t Index;
+	uint32_t Generation;
+};
+
+// SlotPool stores up to Capacity elements inline, without any allocation.
+// Elements are kept densely packed for iteration; removal moves the last
+// element into the hole (O(1), order is not preserved). Stable references
+// to elements are given out as generation-checked PoolHandles.
+// Elements must be trivially copyable, so the pool (and the game owning it)
+// can be copied and saved as plain memory.
+template <typename T, unsigned int Capacity>
+class SlotPool
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SlotPool elements must be trivially copyable");
+public:
+	// constructor
+	SlotPool() : size(0), freeCount(Capacity)
+	{
+		for (unsigned int i = 0; i < Capacity; ++i)
+		{
+			// hand out low slots first
+			this->freeSlots[i] = Capacity - 1 - i;
+			this->generations[i] = 0;
+		}
+	}
+	// dense iteration over all elements
+	T* begin() { return this->items(); }
+	T* end() { return this->items() + this->size; }
+	const T* begin() const { return this->items(); }
+	const T* end() const { return this->items() + this->size; }
+	// number of elements
+	unsigned int Size() const { return this->size; }
+	bool Full() const { return this->size == Capacity; }
+	// element at a dense position
+	T& operator[](unsigned int index) { return this->items()[index]; }
+	const T& operator[](unsigned int index) const { return this->items()[index]; }
+	// constructs an element in place, returns an invalid handle when the pool is full
+	template <typename... Args>
+	PoolHandle Emplace(Args&&... args)
+	{
+		if (this->Full())
+			return PoolHandle{ Capacity, 0 };
+		uint32_t slot = this->freeSlots[--this->freeCount];
+		new (&this->items()[this->size]) T(std::forward<Args>(args)...);
+		this->slotOf[this->size] = slot;
+		this->denseOf[slot] = this->size;
+		++this->size;
+		// odd generations mark live slots
+		return PoolHandle{ slot, ++this->generations[slot] };
+	}
+	// whether the bookkeeping is consistent (a pool copied in from outside, e.g. a
+	// snapshot read from a file, could hold anything): every dense position maps to a
+	// live slot and back, every free slot is unused and listed once
+	bool Valid() const
+	{
+		if (this->size > Capacity || this->freeCount != Capacity - this->size)
+			return false;
+		bool used[Capacity] = {};
+		for (unsigned int i = 0; i < this->size; ++i)
+		{
+			uint32_t slot = this->slotOf[i];
+			if (slot >= Capacity || used[slot] || this->denseOf[slot] != i || !(this->generations[slot] & 1u))
+				return false;
+			used[slot] = true;
+		}
+		for (unsigned int i = 0; i < this->freeCount; ++i)
+		{
+			uint32_t slot = this->freeSlots[i];
+			if (slot >= Capacity || used[slot] || (this->generations[slot] & 1u))
+				return false;
+			used[slot] = true;
+		}
+		return true;
+	}
+	// whether the handle refers to a live element
+	bool Valid(PoolHandle handle) const
+	{
+		return handle.Index < Capacity && this->generations[handle.Index] == handle.Generation && (handle.Generation & 1u);
+	}
+	// element of a handle, nullptr if the element was removed
+	T* Get(PoolHandle handle)
+	{
+		return this->Valid(handle) ? &this->items()[this->denseOf[handle.Index]] : nullptr;
+	}
+	// removes the element of a handle (no-op for invalid handles)
+	void Remove(PoolHandle handle)
+	{
+		if (this->Valid(handle))
+			this->RemoveAt(this->denseOf[handle.Index]);
+	}
+	// removes the element at a dense position by moving the last element into it
+	void RemoveAt(unsigned int index)
+	{
+		uint32_t slot = this->slotOf[index];
+		unsigned int last = this->size - 1;
+		if (index != last)
+		{
+			this->items()[index] = this->items()[last];
+			this->slotOf[index] = this->slotOf[last];
+			this->denseOf[this->slotOf[index]] = index;
+		}
+		--this->size;
+		++this->generations[slot];
+		this->freeSlots[this->freeCount++] = slot;
+	}
+	// removes every element for which remove(element) returns true
+	template <typename Predicate>
+	void RemoveIf(Predicate remove)
+	{
+		for (unsigned int i = 0; i < this->size; )
+		{
+			if (remove(this->items()[i]))
+				this->RemoveAt(i);
+			else
+				++i;
+		}
+	}
+	// removes all elements
+	void Clear()
+	{
+		while (this->size > 0)
+			this->RemoveAt(this->size - 1);
+	}
+private:
+	alignas(T) unsigned char storage[Capacity * sizeof(T)];
+	unsigned int	size;
+	unsigned int	freeCount;
+	uint32_t		slotOf[Capacity];		// dense position -> slot
+	uint32_t		denseOf[Capacity];		// slot -> dense position
+	uint32_t		generations[Capacity];	// per slot, odd while in use
+	uint32_t		freeSlots[Capacity];	// stack of unused slots
+
+	T* items() { return reinterpret_cast<T*>(this->storage); }
+	const T* items() const { return reinterpret_cast<const T*>(this->storage); }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,463 @@
+#include "spectator_stream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+// word of a state, read and written as bytes so floats need no type punning
+uint32_t StateWord(const SpectatorState& state, unsigned int index)
+{
+	uint32_t word;
+	std::memcpy(&word, reinterpret_cast<const uint8_t*>(&state) + index * sizeof(uint32_t), sizeof(word));
+	return word;
+}
+
+void SetStateWord(SpectatorState& state, unsigned int index, uint32_t word)
+{
+	std::memcpy(reinterpret_cast<uint8_t*>(&state) + index * sizeof(uint32_t), &word, sizeof(word));
+}
+
+// FNV-1a over the words of a state, the destroyed cells and the checksum of a level message
+uint32_t FrameChecksum(const SpectatorState& state, const uint32_t* bricks, unsigned int brickCount, uint32_t levelChecksum)
+{
+	uint32_t hash = 2166136261u;
+	auto add = [&](uint32_t word)
+	{
+		for (unsigned int byte = 0; byte < 4; ++byte, word >>= 8)
+			hash = (hash ^ (word & 0xff)) * 16777619u;
+	};
+	for (unsigned int i = 0; i < SPECTATOR_STATE_WORDS; ++i)
+		add(StateWord(state, i));
+	for (unsigned int i = 0; i < brickCount; ++i)
+		add(bricks[i]);
+	add(levelChecksum);
+	return hash;
+}
+
+// FNV-1a over the bytes of a level message
+uint32_t LevelChecksum(const uint8_t* data, size_t size)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ data[i]) * 16777619u;
+	return hash;
+}
+
+uint8_t* PutVarint(uint8_t* out, uint32_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		*out++ = static_cast<uint8_t>(value | 0x80);
+	*out++ = static_cast<uint8_t>(value);
+	return out;
+}
+
+bool GetVarint(const uint8_t*& cursor, const uint8_t* end, uint32_t& value)
+{
+	value = 0;
+	for (unsigned int shift = 0; cursor < end && shift < 32; shift += 7)
+	{
+		uint8_t byte = *cursor++;
+		value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+void CaptureSpectatorState(const Game& game, SpectatorState& state)
+{
+	state.Level = game.Level;
+	state.State = game.State;
+	state.Lives = game.Lives;
+	state.LiveBricks = game.Levels[game.Level].LiveBricks;
+	state.TopRow = game.Levels[game.Level].TopRow;
+	state.Top = game.Levels[game.Level].Top;
+	state.PlayerPosition = game.Player.Position;
+	state.PlayerSize = game.Player.Size;
+	state.BallPosition = game.Ball.Position;
+	state.BallVelocity = game.Ball.Velocity;
+	state.BallRadius = game.Ball.Radius;
+	state.Flags = (game.Ball.Stuck ? SPECTATOR_BALL_STUCK : 0) | (game.Ball.Sticky ? SPECTATOR_BALL_STICKY : 0)
+		| (game.Ball.PassThrough ? SPECTATOR_BALL_PASS_THROUGH : 0) | (game.Effects.Confuse ? SPECTATOR_CONFUSE : 0)
+		| (game.Effects.Chaos ? SPECTATOR_CHAOS : 0) | (game.Effects.Shake ? SPECTATOR_SHAKE : 0);
+	state.PowerUpCount = 0;
+	for (const PowerUP& powerUp : game.PowerUps)
+	{
+		state.PowerUps[state.PowerUpCount].Position = powerUp.Position;
+		state.PowerUps[state.PowerUpCount].Type = powerUp.Type;
+		++state.PowerUpCount;
+	}
+	for (unsigned int i = state.PowerUpCount; i < MAX_POWERUPS; ++i)
+		state.PowerUps[i] = {};
+}
+
+size_t EncodeSpectatorFrame(uint8_t kind, uint32_t frame, const SpectatorState& base, const SpectatorState& state,
+	const uint32_t* bricks, unsigned int brickCount, uint32_t levelChecksum, uint8_t* out)
+{
+	brickCount = std::min(brickCount, MAX_SPECTATOR_BRICKS);
+	uint8_t* cursor = out + sizeof(uint32_t);
+	*cursor++ = kind;
+	cursor = PutVarint(cursor, frame);
+	unsigned int changed = 0;
+	for (unsigned int i = 0; i < SPECTATOR_STATE_WORDS; ++i)
+		changed += StateWord(base, i) != StateWord(state, i);
+	cursor = PutVarint(cursor, changed);
+	// per changed word the number of unchanged words before it
+	unsigned int next = 0;
+	for (unsigned int i = 0; i < SPECTATOR_STATE_WORDS; ++i)
+	{
+		uint32_t word = StateWord(state, i);
+		if (word == StateWord(base, i))
+			continue;
+		cursor = PutVarint(cursor, i - next);
+		std::memcpy(cursor, &word, sizeof(word));
+		cursor += sizeof(word);
+		next = i + 1;
+	}
+	cursor = PutVarint(cursor, brickCount);
+	uint32_t cell = 0;
+	for (unsigned int i = 0; i < brickCount; ++i)
+	{
+		// bricks destroyed together are mostly neighbours, their gaps are small
+		int32_t gap = static_cast<int32_t>(bricks[i] - cell);
+		cursor = PutVarint(cursor, (static_cast<uint32_t>(gap) << 1) ^ static_cast<uint32_t>(gap >> 31));
+		cell = bricks[i];
+	}
+	uint32_t checksum = FrameChecksum(state, bricks, brickCount, levelChecksum);
+	std::memcpy(cursor, &checksum, sizeof(checksum));
+	cursor += sizeof(checksum);
+	uint32_t length = static_cast<uint32_t>(cursor - out - sizeof(uint32_t));
+	std::memcpy(out, &length, sizeof(length));
+	return static_cast<size_t>(cursor - out);
+}
+
+uint32_t EncodeSpectatorLevel(uint32_t frame, const GameLevel& level, std::vector<uint8_t>& out)
+{
+	// the counts are known up front, the brick state is written in place after them
+	size_t stateSize = level.StateSize();
+	out.resize(sizeof(uint32_t) + 1 + 6 * 5 + stateSize + sizeof(uint32_t));
+	uint8_t* payload = out.data() + sizeof(uint32_t);
+	uint8_t* cursor = payload;
+	*cursor++ = SPECTATOR_LEVEL;
+	cursor = PutVarint(cursor, frame);
+	cursor = PutVarint(cursor, level.Columns);
+	cursor = PutVarint(cursor, level.Rows);
+	cursor = PutVarint(cursor, static_cast<uint32_t>(level.Live.size()));
+	cursor = PutVarint(cursor, level.Endless ? static_cast<uint32_t>(level.Tiles.size()) : 0);
+	cursor = PutVarint(cursor, level.Chunks.DeltaCount());
+	level.SaveState(cursor);
+	cursor += stateSize;
+	uint32_t checksum = LevelChecksum(payload, static_cast<size_t>(cursor - payload));
+	std::memcpy(cursor, &checksum, sizeof(checksum));
+	cursor += sizeof(checksum);
+	uint32_t length = static_cast<uint32_t>(cursor - payload);
+	std::memcpy(out.data(), &length, sizeof(length));
+	out.resize(static_cast<size_t>(cursor - out.data()));
+	return checksum;
+}
+
+SpectatorDecoder::SpectatorDecoder()
+	: State(), Frame(0), Bricks(), BrickCount(0), Columns(0), Rows(0), Synced(false), levelFrame(0), levelChecksum(0), levelDecoded(false)
+{
+}
+
+bool SpectatorDecoder::Decode(const uint8_t* payload, size_t size)
+{
+	const uint8_t* cursor = payload;
+	const uint8_t* end = payload + size;
+	uint32_t frame, changed, brickCount;
+	if (size < 1)
+		return false;
+	uint8_t kind = *cursor++;
+	if (!GetVarint(cursor, end, frame) || kind > SPECTATOR_LEVEL)
+		return false;
+	if (kind == SPECTATOR_LEVEL)
+		return this->decodeLevel(payload, cursor, end, frame);
+	// a delta only applies to the frame right before it, a keyframe to the level of its frame
+	if (kind == SPECTATOR_DELTA && (!this->Synced || frame != this->Frame + 1))
+		return this->Synced = false;
+	if (kind == SPECTATOR_KEYFRAME && (!this->levelDecoded || frame != this->levelFrame))
+		return this->Synced = false;
+	if (kind == SPECTATOR_KEYFRAME)
+		this->State = {};
+	if (!GetVarint(cursor, end, changed) || changed > SPECTATOR_STATE_WORDS)
+		return this->Synced = false;
+	uint32_t index = 0;
+	for (uint32_t i = 0; i < changed; ++i)
+	{
+		uint32_t gap, word;
+		if (!GetVarint(cursor, end, gap) || gap >= SPECTATOR_STATE_WORDS - index || end - cursor < 4)
+			return this->Synced = false;
+		index += gap;
+		std::memcpy(&word, cursor, sizeof(word));
+		cursor += sizeof(word);
+		SetStateWord(this->State, index++, word);
+	}
+	if (!GetVarint(cursor, end, brickCount) || brickCount > MAX_SPECTATOR_BRICKS)
+		return this->Synced = false;
+	uint32_t cell = 0;
+	for (uint32_t i = 0; i < brickCount; ++i)
+	{
+		uint32_t gap;
+		if (!GetVarint(cursor, end, gap))
+			return this->Synced = false;
+		cell += static_cast<uint32_t>(static_cast<int32_t>(gap >> 1) ^ -static_cast<int32_t>(gap & 1));
+		this->Bricks[i] = cell;
+	}
+	this->BrickCount = brickCount;
+	uint32_t checksum;
+	if (end - cursor != sizeof(checksum))
+		return this->Synced = false;
+	std::memcpy(&checksum, cursor, sizeof(checksum));
+	if (checksum != FrameChecksum(this->State, this->Bricks, this->BrickCount, kind == SPECTATOR_KEYFRAME ? this->levelChecksum : 0))
+		return this->Synced = false;
+	// the level of a keyframe already lost the bricks of its frame
+	if (kind == SPECTATOR_DELTA && !this->destroyBricks())
+		return this->Synced = false;
+	this->Frame = frame;
+	this->Synced = true;
+	return true;
+}
+
+bool SpectatorDecoder::decodeLevel(const uint8_t* payload, const uint8_t* cursor, const uint8_t* end, uint32_t frame)
+{
+	// deltas of the frames before it do not apply anymore
+	this->Synced = false;
+	this->levelDecoded = false;
+	uint32_t words, tileBytes, deltas;
+	if (!GetVarint(cursor, end, this->Columns) || !GetVarint(cursor, end, this->Rows) || !GetVarint(cursor, end, words)
+		|| !GetVarint(cursor, end, tileBytes) || !GetVarint(cursor, end, deltas))
+		return false;
+	// the bitmap and tiles cover the grid (or are left out)
+	uint64_t cells = static_cast<uint64_t>(this->Columns) * this->Rows;
+	size_t bytes = static_cast<size_t>(words) * sizeof(uint64_t) + tileBytes + static_cast<size_t>(deltas) * CHUNK_DELTA_BYTES;
+	if ((words != 0 && words != (cells + 63) / 64) || (tileBytes != 0 && tileBytes != cells)
+		|| static_cast<size_t>(end - cursor) != bytes + sizeof(uint32_t))
+		return false;
+	uint32_t checksum;
+	std::memcpy(&checksum, cursor + bytes, sizeof(checksum));
+	if (checksum != LevelChecksum(payload, static_cast<size_t>(cursor + bytes - payload)))
+		return false;
+	this->Live.resize(words);
+	if (words > 0)
+		std::memcpy(this->Live.data(), cursor, words * sizeof(uint64_t));
+	cursor += words * sizeof(uint64_t);
+	this->Tiles.assign(cursor, cursor + tileBytes);
+	this->ChunkDeltas.assign(cursor + tileBytes, cursor + bytes - words * sizeof(uint64_t));
+	this->levelFrame = frame;
+	this->levelChecksum = checksum;
+	this->levelDecoded = true;
+	return true;
+}
+
+bool SpectatorDecoder::destroyBricks()
+{
+	uint64_t cells = static_cast<uint64_t>(this->Columns) * this->Rows;
+	for (unsigned int i = 0; i < this->BrickCount; ++i)
+	{
+		uint32_t cell = this->Bricks[i];
+		if (cell >= cells)
+			return false;
+		// chunked levels keep no bitmap here, only the range is checked
+		if (this->Live.empty())
+			continue;
+		uint64_t bit = uint64_t(1) << (cell % 64);
+		if (!(this->Live[cell / 64] & bit))
+			return false;
+		this->Live[cell / 64] &= ~bit;
+	}
+	return true;
+}
+
+SpectatorServer::SpectatorServer()
+	: Attached(0), Keyframes(0), Skipped(0), EncodedBytes(0), running(false), published(0), levelRequested(false), level(),
+	frameBrickCount(0), bricksDropped(false), previous(), levelVersion(0)
+{
+	for (Slot& slot : this->slots)
+		slot.Sequence.store(0, std::memory_order_relaxed);
+}
+
+SpectatorServer::~SpectatorServer()
+{
+	this->Stop();
+}
+
+bool SpectatorServer::Start(uint16_t port)
+{
+	this->Stop();
+	if (!this->listener.Listen(port))
+		return false;
+	this->running = true;
+	this->broadcaster = std::thread(&SpectatorServer::broadcast, this);
+	return true;
+}
+
+void SpectatorServer::Stop()
+{
+	this->running = false;
+	if (this->broadcaster.joinable())
+		this->broadcaster.join();
+	this->listener.Close();
+}
+
+void SpectatorServer::BrickDestroyed(unsigned int cell)
+{
+	if (this->frameBrickCount < MAX_SPECTATOR_BRICKS)
+		this->frameBricks[this->frameBrickCount++] = cell;
+	else
+		this->bricksDropped = true;
+}
+
+void SpectatorServer::Publish(const Game& game)
+{
+	uint32_t number = this->published.load(std::memory_order_relaxed);
+	Slot& slot = this->slots[number % SLOTS];
+	slot.Sequence.store(2 * number + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	PublishedFrame& frame = slot.Frame;
+	frame.Frame = number;
+	CaptureSpectatorState(game, frame.State);
+	std::copy(this->frameBricks, this->frameBricks + this->frameBrickCount, frame.Bricks);
+	frame.BrickCount = this->frameBrickCount;
+	frame.Size = EncodeSpectatorFrame(SPECTATOR_DELTA, number, this->previous, frame.State, frame.Bricks, frame.BrickCount, 0, frame.Bytes);
+	// the level changed other than by the bricks the frame carries (another level, a reset,
+	// a row an endless level refilled or too many bricks): spectators resync from the level
+	if (this->bricksDropped || frame.State.Level != this->previous.Level || frame.State.TopRow != this->previous.TopRow
+		|| frame.State.LiveBricks + frame.BrickCount != this->previous.LiveBricks)
+		++this->levelVersion;
+	frame.LevelVersion = this->levelVersion;
+	// the level message a spectator waits for, captured only when asked for
+	if (this->levelRequested.load(std::memory_order_acquire))
+	{
+		this->level.Checksum = EncodeSpectatorLevel(number, game.Levels[game.Level], this->level.Bytes);
+		this->level.Frame = number;
+		this->levelRequested.store(false, std::memory_order_release);
+	}
+	slot.Sequence.store(2 * number + 2, std::memory_order_release);
+	this->published.store(number + 1, std::memory_order_release);
+	this->previous = frame.State;
+	this->EncodedBytes += frame.Size;
+	this->frameBrickCount = 0;
+	this->bricksDropped = false;
+}
+
+void SpectatorServer::broadcast()
+{
+	std::vector<Client> clients;
+	// the frame being sent and a keyframe encoded from it (too big for the stack of every platform)
+	std::unique_ptr<PublishedFrame> frame = std::make_unique<PublishedFrame>();
+	std::vector<uint8_t> keyframe(MAX_SPECTATOR_FRAME);
+	uint32_t next = this->published.load(std::memory_order_acquire);
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+	while (true)
+	{
+		bool idle = true;
+		TcpSocket socket;
+		while (this->listener.Accept(socket))
+		{
+			clients.push_back({ std::move(socket), {}, 0, false, 0 });
+			clients.back().Buffer.reserve(CLIENT_BUFFER);
+			++this->Attached;
+			idle = false;
+		}
+		// the frames published since the last pass
+		uint32_t last = this->published.load(std::memory_order_acquire);
+		for (; next != last; ++next)
+		{
+			Slot& slot = this->slots[next % SLOTS];
+			uint32_t sequence = 2 * next + 2;
+			bool complete = slot.Sequence.load(std::memory_order_acquire) == sequence;
+			if (complete)
+			{
+				*frame = slot.Frame;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				complete = slot.Sequence.load(std::memory_order_relaxed) == sequence;
+			}
+			if (!complete)
+			{
+				// the game thread lapped this thread: carry on from the newest frame,
+				// every spectator starts over with a keyframe
+				for (Client& client : clients)
+					client.Synced = false;
+				next = this->published.load(std::memory_order_acquire) - 1;
+				break;
+			}
+			for (Client& client : clients)
+				this->enqueue(client, *frame, keyframe.data());
+			idle = false;
+		}
+		// send what the sockets take, spectators that went away are dropped
+		bool pending = false;
+		for (size_t i = 0; i < clients.size(); )
+		{
+			Client& client = clients[i];
+			int sent = client.Sent < client.Buffer.size()
+				? client.Socket.Send(client.Buffer.data() + client.Sent, client.Buffer.size() - client.Sent) : 0;
+			if (sent < 0)
+			{
+				clients.erase(clients.begin() + i);
+				continue;
+			}
+			client.Sent += sent;
+			if (client.Sent == client.Buffer.size())
+			{
+				client.Buffer.clear();
+				client.Sent = 0;
+			}
+			idle = idle && sent == 0;
+			pending = pending || !client.Buffer.empty();
+			++i;
+		}
+		if (!this->running && deadline == std::chrono::steady_clock::time_point::max())
+			deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		if (!this->running && next == this->published.load(std::memory_order_acquire)
+			&& (!pending || std::chrono::steady_clock::now() > deadline))
+			break;
+		if (idle)
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+}
+
+void SpectatorServer::enqueue(Client& client, const PublishedFrame& frame, uint8_t* keyframe)
+{
+	if (client.LevelVersion != frame.LevelVersion)
+		client.Synced = false;
+	if (!client.Synced)
+	{
+		// a keyframe only once everything before it is sent
+		if (client.Sent < client.Buffer.size())
+		{
+			++this->Skipped;
+			return;
+		}
+		// and the level message of its frame, which the game thread captures when asked
+		if (this->levelRequested.load(std::memory_order_acquire) || this->level.Bytes.empty() || this->level.Frame != frame.Frame)
+		{
+			this->levelRequested.store(true, std::memory_order_release);
+			++this->Skipped;
+			return;
+		}
+		// the buffer is empty, a level bigger than it makes it grow
+		size_t size = EncodeSpectatorFrame(SPECTATOR_KEYFRAME, frame.Frame, SpectatorState(), frame.State,
+			frame.Bricks, frame.BrickCount, this->level.Checksum, keyframe);
+		client.Buffer.insert(client.Buffer.end(), this->level.Bytes.begin(), this->level.Bytes.end());
+		client.Buffer.insert(client.Buffer.end(), keyframe, keyframe + size);
+		client.LevelVersion = frame.LevelVersion;
+		client.Synced = true;
+		++this->Keyframes;
+		return;
+	}
+	// make room by dropping the part already sent
+	if (client.Buffer.size() + frame.Size > CLIENT_BUFFER && client.Sent > 0)
+	{
+		client.Buffer.erase(client.Buffer.begin(), client.Buffer.begin() + client.Sent);
+		client.Sent = 0;
+	}
+	if (client.Buffer.size() + frame.Size > CLIENT_BUFFER)
+	{
+		client.Synced = false;
+		++this->Skipped;
+		return;
+	}
+	client.Buffer.insert(client.Buffer.end(), frame.Bytes, frame.Bytes + frame.Size);
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#ifndef SPECTATOR_STREAM_H
+#define SPECTATOR_STREAM_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game.h"
+#include "net_socket.h"
+
+// world state a spectator sees each frame, all 32 bit words so frames are delta
+// encoded word by word (unused power-up entries are zero)
+struct SpectatorState
+{
+	uint32_t	Level, State, Lives, LiveBricks;
+	uint32_t	TopRow;		// row of the level shown at the top and its world y (see GameLevel)
+	float		Top;
+	glm::vec2	PlayerPosition, PlayerSize;
+	glm::vec2	BallPosition, BallVelocity;
+	float		BallRadius;
+	uint32_t	Flags;		// SPECTATOR_* bits
+	uint32_t	PowerUpCount;
+	struct
+	{
+		glm::vec2	Position;
+		uint32_t	Type;
+	}			PowerUps[MAX_POWERUPS];
+};
+const unsigned int SPECTATOR_STATE_WORDS = sizeof(SpectatorState) / sizeof(uint32_t);
+static_assert(sizeof(SpectatorState) % sizeof(uint32_t) == 0, "SpectatorState must consist of 32 bit words");
+
+// bits of SpectatorState::Flags
+const uint32_t SPECTATOR_BALL_STUCK = 1, SPECTATOR_BALL_STICKY = 2, SPECTATOR_BALL_PASS_THROUGH = 4;
+const uint32_t SPECTATOR_CONFUSE = 8, SPECTATOR_CHAOS = 16, SPECTATOR_SHAKE = 32;
+
+// kinds of frames: a keyframe is encoded against the zero state, a delta against the
+// frame before it; a level message holds the brick state of the level, a spectator
+// starts with the level message and keyframe of the same frame
+const uint8_t SPECTATOR_DELTA = 0, SPECTATOR_KEYFRAME = 1, SPECTATOR_LEVEL = 2;
+// bricks destroyed per frame a delta can carry; a frame destroying more (the game
+// dispatches its event queue early when it is full) resyncs the spectators instead
+const unsigned int MAX_SPECTATOR_BRICKS = MAX_EVENTS;
+// upper bound of an encoded frame: the uint32 length, the kind, frame number, changed
+// words (index gap and value), destroyed bricks and checksum
+const size_t MAX_SPECTATOR_FRAME = 4 + 1 + 5 + 3 + SPECTATOR_STATE_WORDS * (3 + 4) + 2 + MAX_SPECTATOR_BRICKS * 5 + 4;
+
+// copies the world state of the game
+void CaptureSpectatorState(const Game& game, SpectatorState& state);
+// encodes frame (state and the bricks destroyed in it) against base into out, which
+// has to hold MAX_SPECTATOR_FRAME bytes; returns the bytes written. A frame is its
+// payload length (uint32), the kind, the frame number, per changed word its index
+// gap and value, the destroyed cells (gaps, zigzag coded) and a checksum of the
+// state and cells (and of the level message for a keyframe, levelChecksum), all
+// numbers but the words and checksum as varints.
+size_t EncodeSpectatorFrame(uint8_t kind, uint32_t frame, const SpectatorState& base, const SpectatorState& state,
+	const uint32_t* bricks, unsigned int brickCount, uint32_t levelChecksum, uint8_t* out);
+// encodes the brick state of the level at the end of frame into out: its length
+// (uint32), the kind, the frame number, columns, rows, bitmap words, tile bytes and
+// chunk deltas as varints, then the brick state as a snapshot holds it (see
+// GameLevel::SaveState) and a checksum of the message; returns the checksum
+uint32_t EncodeSpectatorLevel(uint32_t frame, const GameLevel& level, std::vector<uint8_t>& out);
+
+// SpectatorDecoder rebuilds the world state from a stream of frames
+class SpectatorDecoder
+{
+public:
+	SpectatorState	State;
+	uint32_t		Frame;
+	// cells of the bricks destroyed in the last frame
+	uint32_t		Bricks[MAX_SPECTATOR_BRICKS];
+	unsigned int	BrickCount;
+	// brick state of the level from the last level message: the grid, its bitmap (the
+	// bricks of each delta are cleared in it), the tiles of endless levels and the
+	// chunk deltas of chunked levels
+	uint32_t				Columns, Rows;
+	std::vector<uint64_t>	Live;
+	std::vector<uint8_t>	Tiles, ChunkDeltas;
+	// true once a keyframe was decoded
+	bool			Synced;
+	// constructor
+	SpectatorDecoder();
+	// decodes the payload of a frame (after its length); false if it is malformed,
+	// does not follow the previous frame, destroys a brick that is not live or its
+	// checksum does not match the rebuilt state (a keyframe's includes its level)
+	bool Decode(const uint8_t* payload, size_t size);
+private:
+	// frame and checksum of the last level message, the next keyframe has to be of its frame
+	uint32_t		levelFrame, levelChecksum;
+	bool			levelDecoded;
+	// decodes a level message (payload, its fields from cursor on)
+	bool decodeLevel(const uint8_t* payload, const uint8_t* cursor, const uint8_t* end, uint32_t frame);
+	// clears the bricks of the last frame in the bitmap, false if one of them was not live
+	bool destroyBricks();
+};
+
+// SpectatorServer feeds any number of spectators from one encoded stream. The
+// game thread captures and delta encodes each frame once into a ring of slots
+// (a fixed amount of work without allocations, however many spectators there
+// are); a broadcast thread accepts spectators over TCP on the loopback interface
+// and sends them the frames. A new or lagging spectator (its send buffer full)
+// skips frames until its buffer drained and then carries on from a level message
+// and a keyframe. The game thread only captures the level when the broadcast
+// thread asks for it; spectators resync the same way whenever the level changes
+// other than by destroyed bricks (another level, a reset, a refilled endless row).
+class SpectatorServer
+{
+public:
+	// statistics: spectators attached, keyframes sent, frames skipped for lagging spectators, bytes encoded
+	std::atomic<unsigned int>	Attached, Keyframes, Skipped;
+	unsigned long long			EncodedBytes;
+	// constructor/destructor
+	SpectatorServer();
+	~SpectatorServer();
+	// listens on a port of 127.0.0.1 (0 picks a free one) and starts broadcasting
+	bool Start(uint16_t port);
+	// sends what the spectators' buffers hold (waiting at most a second) and disconnects them
+	void Stop();
+	uint16_t Port() const { return this->listener.Port(); }
+	// game thread: a brick destroyed during the current frame, and the end of the frame
+	void BrickDestroyed(unsigned int cell);
+	void Publish(const Game& game);
+private:
+	// frames kept for the broadcast thread, and the send buffer of a spectator
+	static const unsigned int SLOTS = 64;
+	static const size_t CLIENT_BUFFER = 64 * 1024;
+	// a published frame: its state (for keyframes) and its encoded delta
+	struct PublishedFrame
+	{
+		uint32_t				Frame;
+		uint32_t				LevelVersion;	// changes with the level, see Publish
+		SpectatorState			State;
+		uint32_t				Bricks[MAX_SPECTATOR_BRICKS];
+		unsigned int			BrickCount;
+		size_t					Size;
+		uint8_t					Bytes[MAX_SPECTATOR_FRAME];
+	};
+	// a slot is a seqlock: Sequence is odd while the game thread writes the frame and
+	// 2 * frame + 2 once it is complete, a reader that saw it change copied a torn frame
+	struct Slot
+	{
+		std::atomic<uint32_t>	Sequence;
+		PublishedFrame			Frame;
+	};
+	struct Client
+	{
+		TcpSocket				Socket;
+		std::vector<uint8_t>	Buffer;	// encoded frames not sent yet (from Sent on)
+		size_t					Sent;
+		bool					Synced;	// false: waiting for an empty buffer to send a keyframe
+		uint32_t				LevelVersion;	// of the frames it was sent since its keyframe
+	};
+	// a level message, written by the game thread while levelRequested is set and read
+	// by the broadcast thread while it is not
+	struct PublishedLevel
+	{
+		uint32_t				Frame;
+		uint32_t				Checksum;
+		std::vector<uint8_t>	Bytes;
+	};
+	TcpSocket					listener;
+	std::thread					broadcaster;
+	std::atomic<bool>			running;
+	std::array<Slot, SLOTS>		slots;
+	std::atomic<uint32_t>		published;
+	std::atomic<bool>			levelRequested;
+	PublishedLevel				level;
+	// game thread: the frame being built (bricksDropped: it destroyed more than it carries),
+	// the previous frame's state and the version of the level
+	uint32_t					frameBricks[MAX_SPECTATOR_BRICKS];
+	unsigned int				frameBrickCount;
+	bool						bricksDropped;
+	SpectatorState				previous;
+	uint32_t					levelVersion;
+	void broadcast();
+	// queues a frame for a spectator (the level message and a keyframe if it is not synced)
+	void enqueue(Client& client, const PublishedFrame& frame, uint8_t* keyframe);
+};
+
+#endif
\ No newline at end of file
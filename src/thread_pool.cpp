@@ -0,0 +1,79 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned int threads)
+	: job(nullptr), jobCount(0), generation(0), pending(0), stopping(false)
+{
+	// the calling thread is part of the pool, so spawn one less
+	for (unsigned int i = 1; i < threads; ++i)
+		this->workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->wake.notify_all();
+	for (std::thread& worker : this->workers)
+		worker.join();
+}
+
+unsigned int ThreadPool::Size() const
+{
+	return static_cast<unsigned int>(this->workers.size()) + 1;
+}
+
+void ThreadPool::ParallelFor(unsigned int count, const std::function<void(unsigned int, unsigned int)>& work)
+{
+	if (this->workers.empty())
+	{
+		work(0, count);
+		return;
+	}
+	// publish the job and wake up the workers
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->job = &work;
+		this->jobCount = count;
+		this->pending = static_cast<unsigned int>(this->workers.size());
+		++this->generation;
+	}
+	this->wake.notify_all();
+	// take our own part, then wait for the others
+	this->runPart(0, work, count);
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->done.wait(lock, [this]() { return this->pending == 0; });
+	this->job = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned int index)
+{
+	unsigned int seen = 0;
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->wake.wait(lock, [this, seen]() { return this->stopping || this->generation != seen; });
+		if (this->stopping)
+			return;
+		seen = this->generation;
+		const std::function<void(unsigned int, unsigned int)>& work = *this->job;
+		unsigned int count = this->jobCount;
+		lock.unlock();
+
+		this->runPart(index, work, count);
+
+		lock.lock();
+		if (--this->pending == 0)
+			this->done.notify_one();
+	}
+}
+
+void ThreadPool::runPart(unsigned int index, const std::function<void(unsigned int, unsigned int)>& work, unsigned int count)
+{
+	unsigned long long threads = this->Size();
+	unsigned int begin = static_cast<unsigned int>(static_cast<unsigned long long>(count) * index / threads);
+	unsigned int end = static_cast<unsigned int>(static_cast<unsigned long long>(count) * (index + 1) / threads);
+	if (begin < end)
+		work(begin, end);
+}
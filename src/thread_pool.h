@@ -0,0 +1,40 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool splits a range of work items over a fixed set of threads.
+// ParallelFor blocks until the whole range was processed. The calling
+// thread takes the first part of the range itself, so a pool of a
+// single thread runs everything inline without any synchronization.
+class ThreadPool
+{
+public:
+	// constructor/destructor (threads includes the calling thread)
+	ThreadPool(unsigned int threads);
+	~ThreadPool();
+	// number of threads sharing the work (including the calling thread)
+	unsigned int Size() const;
+	// runs work(begin, end) on contiguous parts of [0, count), one part per thread
+	void ParallelFor(unsigned int count, const std::function<void(unsigned int, unsigned int)>& work);
+private:
+	std::vector<std::thread>	workers;
+	std::mutex					mutex;
+	std::condition_variable		wake, done;
+	// current job
+	const std::function<void(unsigned int, unsigned int)>* job;
+	unsigned int				jobCount;
+	unsigned int				generation;
+	unsigned int				pending;
+	bool						stopping;
+	// waits for jobs and processes the part of the range belonging to index
+	void workerLoop(unsigned int index);
+	// runs the part of the current job belonging to index
+	void runPart(unsigned int index, const std::function<void(unsigned int, unsigned int)>& work, unsigned int count);
+};
+
+#endif
\ No newline at end of file
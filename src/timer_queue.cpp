@@ -0,0 +1,21 @@
+#include "timer_queue.h"
+
+TimerQueue::TimerQueue()
+	: Now(0.0), NextId(1)
+{
+}
+
+uint32_t TimerQueue::Schedule(float delay, TimerEvent event, uint32_t payload)
+{
+	Timer timer = { this->Now + delay, this->NextId++, event, payload };
+	this->Timers.push_back(timer);
+	std::push_heap(this->Timers.begin(), this->Timers.end(), TimerLater);
+	return timer.Id;
+}
+
+bool TimerQueue::TimerLater(const Timer& a, const Timer& b)
+{
+	if (a.Expiry != b.Expiry)
+		return a.Expiry > b.Expiry;
+	return a.Id > b.Id;
+}
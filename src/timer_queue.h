@@ -0,0 +1,58 @@
+#ifndef TIMER_QUEUE_H
+#define TIMER_QUEUE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// things that can happen when a timer expires
+enum TimerEvent
+{
+	TIMER_POWERUP_EXPIRED,	// payload: PowerUpType
+	TIMER_SHAKE_ENDED
+};
+
+// a single scheduled timer, plain data so timers can be saved with the game
+struct Timer
+{
+	double		Expiry;		// game time at which the timer fires
+	uint32_t	Id;			// unique per queue, also orders timers with equal expiry
+	TimerEvent	Event;
+	uint32_t	Payload;
+};
+
+// TimerQueue is a min-heap of timers ordered by expiry. Advancing time only
+// touches the timers that expire, so the per-frame cost does not depend on
+// the number of running timers. Timers are never removed early: owners that
+// need to cancel or replace a timer remember its id and ignore stale ones.
+class TimerQueue
+{
+public:
+	// heap of pending timers (earliest first according to std::push_heap with TimerLater)
+	std::vector<Timer>	Timers;
+	// current game time in seconds
+	double				Now;
+	// id the next scheduled timer receives
+	uint32_t			NextId;
+	// constructor
+	TimerQueue();
+	// schedules event to fire after delay seconds, returns the timer's id
+	uint32_t Schedule(float delay, TimerEvent event, uint32_t payload = 0);
+	// advances the game time by dt and calls fire(timer) for every expired timer in expiry order
+	template <typename Fire>
+	void Advance(float dt, Fire&& fire)
+	{
+		this->Now += dt;
+		while (!this->Timers.empty() && this->Timers.front().Expiry <= this->Now)
+		{
+			std::pop_heap(this->Timers.begin(), this->Timers.end(), TimerLater);
+			Timer timer = this->Timers.back();
+			this->Timers.pop_back();
+			fire(timer);
+		}
+	}
+	// heap order: a fires after b
+	static bool TimerLater(const Timer& a, const Timer& b);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game.h"
+#include "autopilot.h"
+#include "percentile.h"
+#include "replay.h"
+#include "rollback_session.h"
+
+// Versus runner: a two-player versus match over loopback UDP with rollback
+// netcode. Both peers run in this process, each on a thread and socket of its
+// own: a peer plays its board with the autopilot and sees the other board
+// through a RollbackSession, with the latency/loss shim on its outgoing
+// datagrams. Frames are paced at 60 Hz times the speed. The run is reported as
+// JSON per peer (rollbacks, stalls, frame time percentiles), and the boards both
+// peers end with are compared with each other and with the same match played
+// without a network. The exit code is 1 if they differ.
+// usage: breakout_versus [--level N] [--seed S] [--frames F] [--latency MS] [--jitter MS]
+//                        [--loss SHARE] [--speed FACTOR]
+
+// Width of the simulated screen
+const unsigned int SCREEN_WIDTH = 2400;
+// Height of the simulated screen
+const unsigned int SCREEN_HEIGHT = 1200;
+// fixed simulation time step
+const float TIME_STEP = 1.0f / 60.0f;
+// seconds a peer waits for the last inputs of the match before giving up
+const double FINISH_TIMEOUT = 5.0;
+
+// command line options
+struct Options
+{
+	unsigned int		Level = 0;
+	unsigned long long	Seed = 0;
+	unsigned int		Frames = 600;
+	double				Latency = 50.0; // one way, milliseconds
+	double				Jitter = 10.0;
+	float				Loss = 0.05f;
+	double				Speed = 1.0; // multiple of real time
+};
+
+// what a peer reports once the match is over
+struct PeerReport
+{
+	bool				Ok = false;
+	bool				Synchronized = false;
+	uint64_t			Checksum = 0;
+	unsigned int		Rollbacks = 0, ResimulatedFrames = 0, MaxRollback = 0, Stalls = 0;
+	unsigned int		Sent = 0, Dropped = 0, Received = 0, SyncChecks = 0;
+	int64_t				DesyncFrame = -1;
+	std::vector<double>	FrameTimes;
+};
+
+bool ParseOptions(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string flag = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cout << "ERROR::VERSUS: Missing value for " << flag << std::endl;
+			return false;
+		}
+		const char* value = argv[++i];
+		if (flag == "--level")
+			options.Level = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (flag == "--seed")
+			options.Seed = std::strtoull(value, nullptr, 10);
+		else if (flag == "--frames")
+			options.Frames = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (flag == "--latency")
+			options.Latency = std::atof(value);
+		else if (flag == "--jitter")
+			options.Jitter = std::atof(value);
+		else if (flag == "--loss")
+			options.Loss = static_cast<float>(std::atof(value));
+		else if (flag == "--speed")
+			options.Speed = std::max(0.01, std::atof(value));
+		else
+		{
+			std::cout << "ERROR::VERSUS: Unknown option " << flag << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// one frame of a board once its keys are set; a lost or won game of the previous
+// frame starts over right away
+void Tick(Game& game)
+{
+	if (game.State != GAME_ACTIVE)
+	{
+		game.Effects.Chaos = false;
+		game.State = GAME_ACTIVE;
+	}
+	game.ProcessInput(TIME_STEP);
+	game.Update(TIME_STEP);
+}
+
+// sets up the board of a player, both peers set up the same boards
+bool SetUpBoard(Game& board, unsigned int player, const Options& options)
+{
+	board.Seed(options.Seed + player);
+	board.Init();
+	if (options.Level >= board.Levels.size())
+		return false;
+	board.SelectLevel(options.Level);
+	board.State = GAME_ACTIVE;
+	return board.Levels[options.Level].Columns != 0;
+}
+
+// plays the match as the given player, the autopilot sets the local input
+void RunPeer(unsigned int player, const Options& options, UdpSocket& socket, uint16_t remotePort, PeerReport& report)
+{
+	Game board0(SCREEN_WIDTH, SCREEN_HEIGHT), board1(SCREEN_WIDTH, SCREEN_HEIGHT);
+	if (!SetUpBoard(board0, 0, options) || !SetUpBoard(board1, 1, options))
+		return;
+	RollbackSession session(board0, board1, player, socket, remotePort, options.Seed * 2 + player + 1);
+	session.Tick = Tick;
+	session.Shim = { options.Latency / 1000.0, options.Jitter / 1000.0, options.Loss };
+	Game& local = *session.Boards[player];
+	Autopilot autopilot;
+	report.FrameTimes.reserve(options.Frames);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	auto seconds = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+	for (unsigned int tick = 0; session.Frame < options.Frames; ++tick)
+	{
+		session.Poll(seconds());
+		std::chrono::steady_clock::time_point stepStart = std::chrono::steady_clock::now();
+		autopilot.Control(local);
+		if (session.Advance(ReadInput(local)))
+			report.FrameTimes.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - stepStart).count());
+		session.Send(seconds());
+		std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>((tick + 1) * TIME_STEP / options.Speed)));
+	}
+	// exchange the last inputs until both peers have them; the peer may still need a
+	// datagram acknowledging its inputs, so keep sending a little longer than a round trip
+	double finished = -1.0, linger = 2.0 * (session.Shim.Latency + session.Shim.Jitter) + 0.05;
+	double deadline = seconds() + FINISH_TIMEOUT;
+	while (seconds() < deadline)
+	{
+		session.Poll(seconds());
+		if (session.Synchronize() && session.AckedFrame >= session.Frame && finished < 0.0)
+			finished = seconds();
+		if (finished >= 0.0 && seconds() > finished + linger)
+			break;
+		session.Send(seconds());
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	report.Ok = true;
+	report.Synchronized = session.Synchronize();
+	report.Checksum = session.Checksum();
+	report.Rollbacks = session.Rollbacks;
+	report.ResimulatedFrames = session.ResimulatedFrames;
+	report.MaxRollback = session.MaxRollback;
+	report.Stalls = session.Stalls;
+	report.Sent = session.Sent;
+	report.Dropped = session.Dropped;
+	report.Received = session.Received;
+	report.SyncChecks = session.SyncChecks;
+	report.DesyncFrame = session.DesyncFrame;
+}
+
+// checksum of the boards after the match played without a network
+uint64_t PlayOffline(const Options& options)
+{
+	Game board0(SCREEN_WIDTH, SCREEN_HEIGHT), board1(SCREEN_WIDTH, SCREEN_HEIGHT);
+	SetUpBoard(board0, 0, options);
+	SetUpBoard(board1, 1, options);
+	Game* boards[2] = { &board0, &board1 };
+	Autopilot autopilots[2];
+	for (unsigned int frame = 0; frame < options.Frames; ++frame)
+		for (unsigned int player = 0; player < 2; ++player)
+		{
+			autopilots[player].Control(*boards[player]);
+			Tick(*boards[player]);
+		}
+	std::vector<uint8_t> scratch;
+	return StateChecksum(board0, scratch) * 31 + StateChecksum(board1, scratch);
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+		return -1;
+	UdpSocket sockets[2];
+	if (!sockets[0].Open(0) || !sockets[1].Open(0))
+	{
+		std::cout << "ERROR::VERSUS: Failed to open the loopback sockets" << std::endl;
+		return -1;
+	}
+
+	PeerReport reports[2];
+	std::thread peer0(RunPeer, 0u, std::cref(options), std::ref(sockets[0]), sockets[1].Port(), std::ref(reports[0]));
+	std::thread peer1(RunPeer, 1u, std::cref(options), std::ref(sockets[1]), sockets[0].Port(), std::ref(reports[1]));
+	peer0.join();
+	peer1.join();
+	if (!reports[0].Ok || !reports[1].Ok)
+	{
+		std::cout << "ERROR::VERSUS: Failed to load level " << options.Level << std::endl;
+		return -1;
+	}
+	bool inSync = reports[0].Synchronized && reports[1].Synchronized && reports[0].Checksum == reports[1].Checksum;
+	bool matchesOffline = inSync && reports[0].Checksum == PlayOffline(options);
+
+	// report (times in microseconds)
+	const double us = 1e6;
+	std::cout << "{" << std::endl
+		<< "  \"level\": " << options.Level << "," << std::endl
+		<< "  \"seed\": " << options.Seed << "," << std::endl
+		<< "  \"frames\": " << options.Frames << "," << std::endl
+		<< "  \"shim\": {\"latency_ms\": " << options.Latency << ", \"jitter_ms\": " << options.Jitter
+		<< ", \"loss\": " << options.Loss << "}," << std::endl
+		<< "  \"peers\": [" << std::endl;
+	for (unsigned int player = 0; player < 2; ++player)
+	{
+		PeerReport& report = reports[player];
+		std::cout << "    {\"player\": " << player
+			<< ", \"rollbacks\": " << report.Rollbacks
+			<< ", \"resimulated_frames\": " << report.ResimulatedFrames
+			<< ", \"max_rollback\": " << report.MaxRollback
+			<< ", \"stalls\": " << report.Stalls
+			<< ", \"sent\": " << report.Sent
+			<< ", \"dropped\": " << report.Dropped
+			<< ", \"received\": " << report.Received
+			<< ", \"sync_checks\": " << report.SyncChecks
+			<< ", \"desync_frame\": " << report.DesyncFrame
+			<< ", \"frame_us\": {\"p50\": " << Percentile(report.FrameTimes, 50.0) * us
+			<< ", \"p99\": " << Percentile(report.FrameTimes, 99.0) * us
+			<< ", \"max\": " << Percentile(report.FrameTimes, 100.0) * us << "}}"
+			<< (player == 0 ? "," : "") << std::endl;
+	}
+	std::cout << "  ]," << std::endl
+		<< "  \"in_sync\": " << (inSync ? "true" : "false") << "," << std::endl
+		<< "  \"matches_offline\": " << (matchesOffline ? "true" : "false") << std::endl
+		<< "}" << std::endl;
+	return inSync && matchesOffline ? 0 : 1;
+}
\ No newline at end of file
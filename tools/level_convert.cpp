@@ -0,0 +1,34 @@
+#include <iostream>
+#include <string>
+
+#include "game_level.h"
+
+// Level converter: writes a level (text or binary) as a binary .lvlb file, or as
+// a chunked .lvlc file that is paged in while playing.
+// usage: breakout_level_convert <input.lvl> <output.lvlb|output.lvlc>
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::cout << "usage: breakout_level_convert <input.lvl> <output.lvlb|output.lvlc>" << std::endl;
+		return -1;
+	}
+	// the screen size only affects the brick size, not the tile grid
+	GameLevel level;
+	level.Load(argv[1], 1, 1);
+	if (level.Tiles.empty())
+	{
+		std::cout << "ERROR::LEVEL: Failed to load level " << argv[1] << std::endl;
+		return -1;
+	}
+	std::string output = argv[2];
+	bool chunked = output.size() >= 5 && output.compare(output.size() - 5, 5, ".lvlc") == 0;
+	if (!(chunked ? level.SaveChunked(argv[2]) : level.Save(argv[2])))
+	{
+		std::cout << "ERROR::LEVEL: Failed to write level " << argv[2] << std::endl;
+		return -1;
+	}
+	std::cout << level.Columns << "x" << level.Rows << " tiles written to " << argv[2] << std::endl;
+	return 0;
+}
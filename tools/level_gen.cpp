@@ -0,0 +1,65 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "game_level.h"
+#include "level_generator.h"
+
+// Level generator: writes a random level of any size for stress tests, as text
+// (.lvl), binary (.lvlb) or chunked (.lvlc) file depending on the output name.
+// usage: breakout_level_gen <output> <columns> <rows> [--density D] [--solid S]
+//                           [--colours C] [--seed N]
+
+// true if name ends in extension
+bool HasExtension(const std::string& name, const std::string& extension)
+{
+	return name.size() >= extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 4 || argc % 2 != 0)
+	{
+		std::cout << "usage: breakout_level_gen <output> <columns> <rows> [--density D] [--solid S] [--colours C] [--seed N]" << std::endl;
+		return -1;
+	}
+	LevelRecipe recipe = DEFAULT_RECIPE;
+	recipe.Columns = static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10));
+	recipe.Rows = static_cast<unsigned int>(std::strtoul(argv[3], nullptr, 10));
+	for (int i = 4; i < argc; i += 2)
+	{
+		std::string flag = argv[i];
+		const char* value = argv[i + 1];
+		if (flag == "--density")
+			recipe.Density = static_cast<float>(std::atof(value));
+		else if (flag == "--solid")
+			recipe.Solid = static_cast<float>(std::atof(value));
+		else if (flag == "--colours")
+			recipe.Colours = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (flag == "--seed")
+			recipe.Seed = std::strtoull(value, nullptr, 10);
+		else
+		{
+			std::cout << "ERROR::LEVEL: Unknown option " << flag << std::endl;
+			return -1;
+		}
+	}
+	// the screen size only affects the brick size, not the tile grid
+	GameLevel level;
+	level.Create(GenerateTiles(recipe), recipe.Columns, recipe.Rows, 1, 1);
+	if (level.Tiles.empty())
+	{
+		std::cout << "ERROR::LEVEL: Invalid level size " << recipe.Columns << "x" << recipe.Rows << std::endl;
+		return -1;
+	}
+	std::string output = argv[1];
+	bool saved = HasExtension(output, ".lvlb") ? level.Save(argv[1])
+		: HasExtension(output, ".lvlc") ? level.SaveChunked(argv[1]) : level.SaveText(argv[1]);
+	if (!saved)
+	{
+		std::cout << "ERROR::LEVEL: Failed to write level " << argv[1] << std::endl;
+		return -1;
+	}
+	std::cout << level.Columns << "x" << level.Rows << " tiles (" << level.LiveBricks << " destructible bricks) written to " << argv[1] << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "percentile.h"
+#include "replay.h"
+#include "shared_state.h"
+
+// External agent: attaches to the state export of a game (breakout_headless
+// --export NAME or BreakOut --export NAME), reads every frame from shared memory
+// and plays by writing keys into the segment's input channel. It reports how
+// long frames took from being published to being read, how many it missed and
+// how often a read raced the game, as JSON, once the game closed the export or
+// after the given seconds.
+// usage: breakout_agent <name> [--seconds S]
+
+// bit of a key in an input mask
+uint8_t KeyBit(int key)
+{
+	for (unsigned int i = 0; i < REPLAY_KEY_COUNT; ++i)
+		if (REPLAY_KEYS[i] == key)
+			return static_cast<uint8_t>(1 << i);
+	return 0;
+}
+
+// keys for the coming frame: launch right away and keep the paddle under the ball,
+// a little off-center towards the middle so the ball is sent across the screen
+uint8_t Control(const SpectatorState& state, float worldWidth)
+{
+	if (state.Flags & SPECTATOR_BALL_STUCK)
+		return KeyBit(GLFW_KEY_SPACE);
+	float ball = state.BallPosition.x + state.BallRadius;
+	float offset = state.PlayerSize.x * 0.3f;
+	float target = ball < worldWidth / 2.0f ? ball - offset : ball + offset;
+	float center = state.PlayerPosition.x + state.PlayerSize.x / 2.0f;
+	float tolerance = state.PlayerSize.x / 8.0f;
+	if (target < center - tolerance)
+		return KeyBit(GLFW_KEY_A);
+	if (target > center + tolerance)
+		return KeyBit(GLFW_KEY_D);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2 || argc % 2 != 0)
+	{
+		std::cout << "usage: breakout_agent <name> [--seconds S]" << std::endl;
+		return -1;
+	}
+	double seconds = 60.0;
+	for (int i = 2; i < argc; i += 2)
+	{
+		std::string flag = argv[i];
+		if (flag == "--seconds")
+			seconds = std::atof(argv[i + 1]);
+		else
+		{
+			std::cout << "ERROR::AGENT: Unknown option " << flag << std::endl;
+			return -1;
+		}
+	}
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now()
+		+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+	// the game may not have created the segment yet
+	SharedStateReader reader;
+	while (!reader.Open(argv[1]))
+	{
+		if (std::chrono::steady_clock::now() >= end)
+		{
+			std::cout << "ERROR::AGENT: No state export named " << argv[1] << std::endl;
+			return -1;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	SharedFrame frame = {};
+	std::vector<double> latencies;
+	unsigned long long missed = 0;
+	unsigned int lastFrame = 0;
+	bool seen = false;
+	while (reader.Live() && std::chrono::steady_clock::now() < end)
+	{
+		if (!reader.Read(frame) || (seen && frame.Frame == lastFrame))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		latencies.push_back((SharedClock() - frame.PublishedAt) * 1e-3);
+		if (seen)
+			missed += frame.Frame - lastFrame - 1;
+		seen = true;
+		lastFrame = frame.Frame;
+		reader.WriteInput(Control(frame.State, frame.WorldSize.x));
+	}
+
+	size_t frames = latencies.size();
+	std::cout << "{" << std::endl
+		<< "  \"frames_read\": " << frames << "," << std::endl
+		<< "  \"frames_missed\": " << missed << "," << std::endl
+		<< "  \"read_retries\": " << reader.Retries << "," << std::endl
+		<< "  \"last_frame\": " << lastFrame << "," << std::endl
+		<< "  \"lives\": " << frame.State.Lives << "," << std::endl
+		<< "  \"live_bricks\": " << frame.State.LiveBricks << "," << std::endl
+		<< "  \"state_latency_us\": {"
+		<< "\"p50\": " << Percentile(latencies, 50.0)
+		<< ", \"p99\": " << Percentile(latencies, 99.0)
+		<< ", \"max\": " << Percentile(latencies, 100.0) << "}" << std::endl
+		<< "}" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spectator_stream.h"
+
+// Spectator client: attaches spectators to a spectator server (breakout_headless
+// --spectate PORT) and checks that every frame rebuilds the world state bit for
+// bit: each frame's checksum is compared with the state rebuilt from it, a keyframe
+// has to follow the level message of its frame (its checksum covers the level), a
+// delta has to follow the frame before it and only destroy bricks that are live in
+// the level rebuilt from them. The run ends when the server closes
+// the connections or after the given seconds, and is reported as JSON.
+// The exit code is 1 if any frame failed to decode.
+// usage: breakout_spectator <port> [--clients N] [--seconds S]
+
+// a spectator: its connection, the bytes of the frame being received and what it saw
+struct Spectator
+{
+	TcpSocket				Socket;
+	std::vector<uint8_t>	Buffer;
+	SpectatorDecoder		Decoder;
+	unsigned long long		Bytes = 0;
+	unsigned int			Frames = 0, Keyframes = 0, Levels = 0, Errors = 0, Bricks = 0;
+	uint32_t				FirstFrame = 0;
+};
+
+// decodes the complete frames in the spectator's buffer
+void DecodeFrames(Spectator& spectator)
+{
+	size_t offset = 0;
+	while (spectator.Buffer.size() - offset >= sizeof(uint32_t))
+	{
+		uint32_t length;
+		std::memcpy(&length, spectator.Buffer.data() + offset, sizeof(length));
+		if (spectator.Buffer.size() - offset - sizeof(length) < length)
+			break;
+		const uint8_t* payload = spectator.Buffer.data() + offset + sizeof(length);
+		if (!spectator.Decoder.Decode(payload, length))
+			++spectator.Errors;
+		else if (payload[0] == SPECTATOR_LEVEL)
+			++spectator.Levels;
+		else
+		{
+			if (spectator.Frames++ == 0)
+				spectator.FirstFrame = spectator.Decoder.Frame;
+			spectator.Keyframes += payload[0] == SPECTATOR_KEYFRAME;
+			spectator.Bricks += spectator.Decoder.BrickCount;
+		}
+		offset += sizeof(length) + length;
+	}
+	spectator.Buffer.erase(spectator.Buffer.begin(), spectator.Buffer.begin() + offset);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2 || argc % 2 != 0)
+	{
+		std::cout << "usage: breakout_spectator <port> [--clients N] [--seconds S]" << std::endl;
+		return -1;
+	}
+	uint16_t port = static_cast<uint16_t>(std::strtoul(argv[1], nullptr, 10));
+	unsigned int count = 1;
+	double seconds = 60.0;
+	for (int i = 2; i < argc; i += 2)
+	{
+		std::string flag = argv[i];
+		if (flag == "--clients")
+			count = static_cast<unsigned int>(std::strtoul(argv[i + 1], nullptr, 10));
+		else if (flag == "--seconds")
+			seconds = std::atof(argv[i + 1]);
+		else
+		{
+			std::cout << "ERROR::SPECTATOR: Unknown option " << flag << std::endl;
+			return -1;
+		}
+	}
+
+	std::vector<Spectator> spectators(count);
+	for (Spectator& spectator : spectators)
+		if (!spectator.Socket.Connect(port))
+		{
+			std::cout << "ERROR::SPECTATOR: Failed to connect to port " << port << std::endl;
+			return -1;
+		}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now()
+		+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+	uint8_t chunk[16 * 1024];
+	unsigned int open = count;
+	while (open > 0 && std::chrono::steady_clock::now() < end)
+	{
+		bool idle = true;
+		for (Spectator& spectator : spectators)
+		{
+			if (!spectator.Socket.IsOpen())
+				continue;
+			int received = spectator.Socket.Receive(chunk, sizeof(chunk));
+			if (received < 0)
+			{
+				spectator.Socket.Close();
+				--open;
+				continue;
+			}
+			spectator.Bytes += received;
+			spectator.Buffer.insert(spectator.Buffer.end(), chunk, chunk + received);
+			DecodeFrames(spectator);
+			idle = idle && received == 0;
+		}
+		if (idle)
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+
+	unsigned int errors = 0;
+	std::cout << "{" << std::endl << "  \"spectators\": [" << std::endl;
+	for (size_t i = 0; i < spectators.size(); ++i)
+	{
+		const Spectator& spectator = spectators[i];
+		errors += spectator.Errors;
+		std::cout << "    {\"frames\": " << spectator.Frames
+			<< ", \"first_frame\": " << spectator.FirstFrame
+			<< ", \"last_frame\": " << spectator.Decoder.Frame
+			<< ", \"keyframes\": " << spectator.Keyframes
+			<< ", \"levels\": " << spectator.Levels
+			<< ", \"bricks_destroyed\": " << spectator.Bricks
+			<< ", \"bytes_per_frame\": " << static_cast<double>(spectator.Bytes) / std::max(1u, spectator.Frames)
+			<< ", \"errors\": " << spectator.Errors << "}"
+			<< (i + 1 < spectators.size() ? "," : "") << std::endl;
+	}
+	std::cout << "  ]" << std::endl << "}" << std::endl;
+	return errors == 0 ? 0 : 1;
+}
\ No newline at end of file